@@ -0,0 +1,220 @@
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <experimental/filesystem>
+#include <at_logging>
+
+#include "streams.h"
+#include "ppc/decoder.h"
+#include "ppc/decode_cache.h"
+#include "ppc/instruction.h"
+#include "ppc/disassembler.h"
+#include "ppc/decompiler.h"
+#include "ppc/call_graph.h"
+#include "ppc/ssa.h"
+#include "ppc/symbol.h"
+#include "ppc/code_section.h"
+#include "mapped_file.h"
+
+namespace fs = std::experimental::filesystem;
+
+// Every allocation in the process goes through here, so benchmarks can report allocations per instruction
+static std::atomic<ulong> allocations {0};
+
+static void* allocate(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *out = std::malloc(size ? size : 1);
+    if (out == nullptr) {
+        throw std::bad_alloc();
+    }
+    return out;
+}
+
+static void release(void *ptr) {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+namespace bench {
+
+// Keeps results alive so the work isn't optimized out
+static volatile ulong sink;
+
+static constexpr double MIN_SECONDS = 0.2;
+
+/**
+ * Run a benchmark over a stream until at least MIN_SECONDS have passed, and print one CSV row.
+ * The body processes the whole stream once per call.
+ */
+static void run(const std::string& name, const Stream& stream, const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+
+    // Warm up, so one time setup like pattern compilation isn't counted
+    body();
+
+    ulong iterations = 0;
+    ulong start_allocations = allocations.load();
+    clock::time_point start = clock::now();
+    double seconds = 0;
+    do {
+        body();
+        iterations++;
+        seconds = std::chrono::duration<double>(clock::now() - start).count();
+    } while (seconds < MIN_SECONDS);
+    ulong total_allocations = allocations.load() - start_allocations;
+
+    double instructions = (double)stream.instructions() * iterations;
+    std::printf("%s,%s,%zu,%lu,%.3f,%.3f,%.2f\n", name.c_str(), stream.name.c_str(), stream.instructions(),
+                iterations, seconds * 1e9 / instructions, total_allocations / instructions,
+                stream.data.size() * iterations / seconds / 1e6);
+    std::fflush(stdout);
+}
+
+static void run_all(const Stream& stream, const fs::path& directory) {
+    const uchar *data = stream.data.data();
+    const std::size_t count = stream.instructions();
+
+    std::vector<PPC::Instruction> instructions;
+    for (std::size_t i = 0; i < count; ++i) {
+        instructions.emplace_back(PPC::decode(data + i * 4));
+    }
+
+    std::string file_in = (directory / (stream.name + ".bin")).string();
+    std::string file_out = (directory / (stream.name + ".ppc")).string();
+    {
+        std::ofstream out(file_in, std::ios::binary);
+        out.write((const char*)data, stream.data.size());
+    }
+
+    for (bool cache : {false, true}) {
+        PPC::set_decode_cache(cache);
+        std::string suffix = cache ? "+cache" : "";
+
+        run("create_instruction" + suffix, stream, [&]() {
+            for (std::size_t i = 0; i < count; ++i) {
+                PPC::Instruction *instruction = PPC::create_instruction(data + i * 4);
+                sink = sink + instruction->get_decoded().word;
+                delete instruction;
+            }
+        });
+
+        run("get_variables" + suffix, stream, [&]() {
+            for (const auto& instruction : instructions) {
+                sink = sink + instruction.get_variables().length();
+            }
+        });
+
+        run("disassemble" + suffix, stream, [&]() {
+            PPC::disassemble(file_in, file_out, 0, (int)stream.data.size(), true);
+        });
+    }
+    PPC::set_decode_cache(false);
+
+    run("disassemble+jobs", stream, [&]() {
+        PPC::disassemble(file_in, file_out, 0, (int)stream.data.size(), true, 0);
+    });
+
+    run("used_registers", stream, [&]() {
+        for (const auto& instruction : instructions) {
+            sink = sink + instruction.used_registers().size();
+        }
+    });
+
+    run("generate_symbols", stream, [&]() {
+        MappedFile file(file_in);
+        PPC::CodeSection section(file.bytes());
+        sink = sink + section.get_symbols().size();
+    });
+
+    {
+        MappedFile file(file_in);
+        PPC::CodeSection section(file.bytes());
+        const std::vector<PPC::Symbol>& symbols = section.get_symbols();
+        for (uint jobs : {1u, 0u}) {
+            run(jobs == 1 ? "generate_inputs" : "generate_inputs+jobs", stream, [&]() {
+                std::vector<PPC::Symbol> fresh;
+                fresh.reserve(symbols.size());
+                for (const auto& symbol : symbols) {
+                    fresh.emplace_back(symbol.start, symbol.end, symbol.name);
+                    fresh.back().instructions = symbol.instructions;
+                }
+                PPC::generate_inputs(fresh, jobs);
+                sink = sink + fresh[0].get_input_regular();
+            });
+        }
+
+        PPC::SSAFunction ir;
+        run("build_ssa", stream, [&]() {
+            for (const auto& symbol : symbols) {
+                ir.build(symbol.instructions, symbol.start);
+                sink = sink + ir.size();
+            }
+        });
+
+        run("summarize_calls", stream, [&]() {
+            PPC::CallGraph graph(std::vector<PPC::CodeSection*> {&section});
+            sink = sink + graph.summarize(1).computed;
+        });
+
+        const std::string file_c = (directory / (stream.name + ".c")).string();
+        run("decompile", stream, [&]() {
+            PPC::decompile(file.bytes(), file_c, 0, 1);
+        });
+        run("decompile+jobs", stream, [&]() {
+            PPC::decompile(std::vector<PPC::DecompileUnit> {{file.bytes(), 0, file_c}}, 0);
+        });
+        fs::remove(file_c);
+    }
+
+    fs::remove(file_in);
+    fs::remove(file_out);
+}
+
+}
+
+int main(int argc, char **argv) {
+    logging::set_default_level(logging::WARN);
+
+    std::size_t count = 1u << 16;
+    if (argc > 1) {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    fs::path directory = fs::temp_directory_path();
+
+    // One row per benchmark and stream
+    std::printf("benchmark,stream,instructions,iterations,ns_per_instruction,allocs_per_instruction,mb_per_s\n");
+    bench::run_all(bench::random_stream(count), directory);
+    bench::run_all(bench::mixed_stream(count), directory);
+
+    return 0;
+}
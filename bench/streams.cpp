@@ -0,0 +1,142 @@
+
+#include "streams.h"
+#include "ppc/decoder.h"
+
+namespace bench {
+
+class Random {
+
+    uint state;
+
+public:
+
+    explicit Random(uint seed) : state(seed ? seed : 1) {}
+
+    uint next() {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint below(uint limit) {
+        return next() % limit;
+    }
+
+};
+
+static void push_word(std::vector<uchar>& out, uint word) {
+    out.push_back((uchar)(word >> 24));
+    out.push_back((uchar)(word >> 16));
+    out.push_back((uchar)(word >> 8));
+    out.push_back((uchar)word);
+}
+
+static bool is_known(uint word) {
+    PPC::DecodedInstruction inst = PPC::decode(word);
+    return inst.mnemonic != PPC::Mnemonic::PADDING && PPC::mnemonic_name(inst.mnemonic).substr(0, 7) != "UNKNOWN";
+}
+
+Stream random_stream(std::size_t count, uint seed) {
+    Stream out {"random", {}};
+    out.data.reserve(count * 4);
+
+    Random random(seed);
+    while (out.instructions() < count) {
+        // Random words almost never form a blr, so end a function every so often to keep every word in one
+        if (out.instructions() % 64 == 63) {
+            push_word(out.data, 0x4E800020u);
+            continue;
+        }
+        uint word = random.next();
+        if (is_known(word)) {
+            push_word(out.data, word);
+        }
+    }
+    return out;
+}
+
+static uint d_form(uint opcode, uint rd, uint ra, uint imm) {
+    return (opcode << 26) | (rd << 21) | (ra << 16) | (imm & 0xFFFF);
+}
+
+static uint x_form(uint opcode, uint rd, uint ra, uint rb, uint xo) {
+    return (opcode << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (xo << 1);
+}
+
+static uint a_form(uint opcode, uint rd, uint ra, uint rb, uint rc, uint xo) {
+    return (opcode << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (rc << 6) | (xo << 1);
+}
+
+static uint body_word(Random& random) {
+    uint rd = 3 + random.below(29), ra = 3 + random.below(29), rb = 3 + random.below(29);
+    uint offset = random.below(0x80) * 4;
+    uint pick = random.below(100);
+
+    if (pick < 20) {
+        return d_form(32, rd, ra, offset);                          // lwz
+    } else if (pick < 32) {
+        return d_form(36, rd, ra, offset);                          // stw
+    } else if (pick < 40) {
+        return d_form(14, rd, ra, random.below(0x100));             // addi
+    } else if (pick < 44) {
+        return d_form(14, rd, 0, random.below(0x100));              // li
+    } else if (pick < 50) {
+        return (18u << 26) | ((random.below(0x100000) * 4) & 0x3FFFFFC) | 1u;  // bl
+    } else if (pick < 55) {
+        return d_form(11, 0, ra, random.below(0x40));               // cmpwi
+    } else if (pick < 62) {
+        return (16u << 26) | ((random.next() & 1u ? 12u : 4u) << 21) | (2u << 16) | (random.below(0x40) * 4);  // beq/bne
+    } else if (pick < 70) {
+        return x_form(31, ra, rd, ra, 444);                         // mr
+    } else if (pick < 76) {
+        return d_form(48, rd, ra, offset);                          // lfs
+    } else if (pick < 80) {
+        return d_form(52, rd, ra, offset);                          // stfs
+    } else if (pick < 83) {
+        return a_form(59, rd, ra, 0, rb, 25);                       // fmuls
+    } else if (pick < 86) {
+        return a_form(59, rd, ra, rb, 0, 21);                       // fadds
+    } else if (pick < 91) {
+        return (21u << 26) | (rd << 21) | (ra << 16) | (random.below(32) << 11) | (random.below(32) << 6) | (31u << 1);  // rlwinm
+    } else if (pick < 94) {
+        return d_form(34, rd, ra, random.below(0x40));              // lbz
+    } else if (pick < 96) {
+        return d_form(24, ra, rd, random.below(0x10000));           // ori
+    } else if (pick < 98) {
+        return x_form(31, rd, ra, rb, 40);                          // subf
+    }
+    return x_form(31, rd, ra, rb, 266);                             // add
+}
+
+Stream mixed_stream(std::size_t count, uint seed) {
+    Stream out {"mixed", {}};
+    out.data.reserve(count * 4 + 64);
+
+    Random random(seed);
+    while (out.instructions() < count) {
+        uint frame = 0x10 + random.below(8) * 0x10;
+        uint body = 8 + random.below(64);
+
+        push_word(out.data, d_form(37, 1, 1, -frame));             // stwu r1, -frame(r1)
+        push_word(out.data, 0x7C0802A6u);                           // mflr r0
+        push_word(out.data, d_form(36, 0, 1, frame + 4));          // stw r0, frame + 4(r1)
+        push_word(out.data, d_form(36, 31, 1, frame - 4));         // stw r31, frame - 4(r1)
+        for (uint i = 0; i < body; ++i) {
+            push_word(out.data, body_word(random));
+        }
+        push_word(out.data, d_form(32, 0, 1, frame + 4));          // lwz r0, frame + 4(r1)
+        push_word(out.data, d_form(32, 31, 1, frame - 4));         // lwz r31, frame - 4(r1)
+        push_word(out.data, 0x7C0803A6u);                           // mtlr r0
+        push_word(out.data, d_form(14, 1, 1, frame));              // addi r1, r1, frame
+        push_word(out.data, 0x4E800020u);                           // blr
+        // Functions are aligned, so some are followed by padding
+        while (out.instructions() % 4 != 0) {
+            push_word(out.data, 0);
+        }
+    }
+    return out;
+}
+
+}
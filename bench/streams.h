@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+namespace bench {
+
+// A synthetic instruction stream, stored big-endian like it would be in a DOL
+struct Stream {
+
+    std::string name;
+    std::vector<uchar> data;
+
+    std::size_t instructions() const {
+        return data.size() / 4;
+    }
+
+};
+
+// Uniformly random words, keeping only ones that decode to a known instruction, with a blr every 64 words
+Stream random_stream(std::size_t count, uint seed = 1);
+// Functions with a prologue, epilogue and a body weighted like typical compiled game code
+Stream mixed_stream(std::size_t count, uint seed = 1);
+
+}
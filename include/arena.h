@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "types.h"
+
+/**
+ * A bump allocator. Allocations are carved out of large blocks and never freed one by one, the
+ * whole arena is released at once when it's reset or destroyed. Only for trivially destructible
+ * types, nothing handed out has its destructor run.
+ */
+class Arena {
+
+	struct Block {
+		std::unique_ptr<uchar[]> data;
+		std::size_t size;
+	};
+
+	std::vector<Block> blocks;
+	// Bytes used in the last block
+	std::size_t used;
+	std::size_t handed_out;
+	std::size_t block_size;
+
+	void *grow(std::size_t size, std::size_t align);
+
+public:
+
+	static constexpr std::size_t DEFAULT_BLOCK = 1u << 16;
+
+	explicit Arena(std::size_t block_size = DEFAULT_BLOCK);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	Arena(Arena&&) noexcept;
+	Arena& operator=(Arena&&) noexcept;
+
+	void *allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+	template<typename T>
+	T *allocate_array(std::size_t count);
+	// Copy text into the arena, the view lives as long as the arena isn't reset
+	std::string_view copy(std::string_view text);
+
+	// Release everything, keeping the largest block around for reuse
+	void reset();
+
+	// Bytes handed out, and bytes held in blocks
+	std::size_t allocated() const;
+	std::size_t capacity() const;
+
+};
+
+template<typename T>
+T *Arena::allocate_array(std::size_t count) {
+	static_assert(std::is_trivially_destructible<T>::value, "Arena memory is never destructed");
+	return (T*)this->allocate(count * sizeof(T), alignof(T));
+}
+
+/**
+ * A growable array kept in an arena. Growing copies into a bigger allocation and leaves the old one
+ * to the arena, so at most about twice the final size is used, and all of it goes with the arena's
+ * next reset. Like allocate_array, only for trivially copyable types.
+ */
+template<typename T>
+class ArenaVector {
+
+	static_assert(std::is_trivially_copyable<T>::value, "ArenaVector moves items with memcpy");
+
+	Arena *arena;
+	T *items;
+	std::size_t count, space;
+
+public:
+
+	ArenaVector() : arena(nullptr), items(nullptr), count(0), space(0) {}
+	explicit ArenaVector(Arena& arena, std::size_t reserve = 0) : ArenaVector() {
+		this->arena = &arena;
+		if (reserve > 0) {
+			this->items = arena.allocate_array<T>(reserve);
+			this->space = reserve;
+		}
+	}
+
+	// Add count default items to the end, returning the first. Pointers from before may be stale
+	T *extend(std::size_t added) {
+		if (this->count + added > this->space) {
+			std::size_t space = this->space < 16 ? 16 : this->space * 2;
+			while (space < this->count + added) {
+				space *= 2;
+			}
+			T *items = this->arena->template allocate_array<T>(space);
+			if (this->count > 0) {
+				std::memcpy((void*)items, (const void*)this->items, this->count * sizeof(T));
+			}
+			this->items = items;
+			this->space = space;
+		}
+		T *out = this->items + this->count;
+		for (std::size_t i = 0; i < added; ++i) {
+			out[i] = T();
+		}
+		this->count += added;
+		return out;
+	}
+
+	void push_back(const T& item) {
+		*this->extend(1) = item;
+	}
+	void pop_back() {
+		this->count--;
+	}
+	T& back() {
+		return this->items[this->count - 1];
+	}
+
+	T& operator[](std::size_t index) {
+		return this->items[index];
+	}
+	const T& operator[](std::size_t index) const {
+		return this->items[index];
+	}
+
+	T *data() {
+		return this->items;
+	}
+	const T *data() const {
+		return this->items;
+	}
+	T *begin() {
+		return this->items;
+	}
+	T *end() {
+		return this->items + this->count;
+	}
+	const T *begin() const {
+		return this->items;
+	}
+	const T *end() const {
+		return this->items + this->count;
+	}
+	std::size_t size() const {
+		return this->count;
+	}
+	bool empty() const {
+		return this->count == 0;
+	}
+
+};
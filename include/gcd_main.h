@@ -1,16 +1,33 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
 #include <argparser.h>
 
 #include "filetypes/rel.h"
 #include "filetypes/dol.h"
+#include "section_cache.h"
+#include "ppc/symbol_map.h"
 
 typedef int(*command_handler)(const std::string&, const std::string&, ArgParser&);
 
-void process_rel(types::REL *rel, const std::vector<types::REL*>& knowns, const std::string& output, bool info);
-void process_dol(types::DOL *dol, const std::string& output, bool info);
+// What to make for each code section while dumping
+struct DumpOptions {
+    bool info = true;
+    // Threads to disassemble on, 0 for one per core. decomp starts from 0 instead
+    uint jobs = 1;
+    bool decomp = false;
+    bool index = false;
+    // Where to reuse unchanged sections' outputs from, if anywhere
+    std::unique_ptr<SectionCache> cache;
+    // Names for the DOL's functions, if given. REL code is relocated, so it keeps generated names
+    std::unique_ptr<PPC::SymbolMap> names;
+};
+
+void process_rel(types::REL *rel, const std::vector<types::REL*>& knowns, const std::string& output,
+                 const DumpOptions& options);
+void process_dol(types::DOL *dol, const std::string& output, const DumpOptions& options);
 
 int command_decomp(const std::string& input, const std::string& output, ArgParser& parser);
 int command_dump(const std::string& input, const std::string& output, ArgParser& parser);
@@ -18,5 +35,7 @@ int command_recomp(const std::string& input, const std::string& output, ArgParse
 
 int command_rel(const std::string& input, const std::string& output, ArgParser& parser);
 int command_dol(const std::string& input, const std::string& output, ArgParser& parser);
+int command_query(const std::string& input, const std::string& output, ArgParser& parser);
+int command_map(const std::string& input, const std::string& output, ArgParser& parser);
 
 int command_tpl(const std::string& input, const std::string& output, ArgParser& parser);
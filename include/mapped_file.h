@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+/**
+ * A read-only view of a run of bytes. Stands in for std::span, which needs C++20.
+ */
+struct ByteSpan {
+
+	const uchar *data;
+	std::size_t size;
+
+	ByteSpan();
+	ByteSpan(const uchar *data, std::size_t size);
+	ByteSpan(const std::vector<uchar>& data);
+
+	const uchar *begin() const;
+	const uchar *end() const;
+	bool empty() const;
+	const uchar &operator[](std::size_t index) const;
+	// Clamped to this span, so an out of range request gives a shorter or empty span
+	ByteSpan subspan(std::size_t offset, std::size_t length = (std::size_t)-1) const;
+
+};
+
+/**
+ * A whole file mapped read-only into memory. If mapping fails the file is read into a buffer
+ * instead, so bytes() is always usable for a file that could be opened.
+ */
+class MappedFile {
+
+	ByteSpan view;
+	void *mapping;
+	std::vector<uchar> buffer;
+	bool opened;
+
+	void read_fallback(const std::string& filename);
+	void unmap();
+
+public:
+
+	explicit MappedFile(const std::string& filename);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	MappedFile &operator=(const MappedFile&) = delete;
+	MappedFile &operator=(MappedFile&& other) noexcept;
+
+	bool is_open() const;
+	bool is_mapped() const;
+	std::size_t size() const;
+	ByteSpan bytes() const;
+
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "types.h"
+
+// Worker count to use when 0 jobs are asked for, at least 1
+uint hardware_jobs();
+
+/**
+ * Call body(i) for every i in [0, count), spread over up to jobs threads including the caller.
+ * Indices are handed out one at a time from a shared counter, so uneven work still balances.
+ * Returns once every call is done, rethrowing the first exception a body threw.
+ */
+void parallel_for(std::size_t count, uint jobs, const std::function<void(std::size_t)>& body);
+
+/**
+ * Runs tasks on a fixed set of workers, each with its own deque. A worker takes the newest task from its
+ * own deque and steals the oldest from another once it runs dry, so tasks of very different sizes still
+ * keep every worker busy. Workers that find nothing to steal sleep until a task is pushed or all are done. Tasks may push more tasks while they run, those go on the running worker's deque.
+ */
+class TaskScheduler {
+
+public:
+
+	using Task = std::function<void()>;
+
+private:
+
+	struct Worker {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	// Tasks pushed and not yet finished, workers stop once it reaches 0
+	std::atomic<std::size_t> pending;
+	// Tasks sitting in a deque. Workers with nothing to take sleep on idle until it or pending changes
+	std::atomic<std::size_t> queued;
+	std::mutex idle_lock;
+	std::condition_variable idle;
+	uint next_worker;
+	std::exception_ptr error;
+	std::mutex error_lock;
+
+	bool take(uint worker, Task& out);
+	void work(uint worker);
+
+public:
+
+	// jobs workers including the thread that calls run, 0 for one per hardware thread
+	explicit TaskScheduler(uint jobs = 0);
+
+	uint size() const;
+	// Queue a task. Pushes from outside a task are dealt round the workers in turn
+	void push(Task task);
+	// Run every task, including ones pushed along the way, then return. If a task throws, the tasks still
+	// queued are dropped and the first exception is rethrown here
+	void run();
+
+};
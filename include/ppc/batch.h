@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "ppc/decoder.h"
+
+namespace PPC {
+
+/**
+ * A run of decoded instructions stored as structure-of-arrays, filled by decode_range.
+ * xo holds the raw bits 21-30, get() resolves the family specific extended opcode.
+ */
+struct DecodedBlock {
+
+    std::vector<uint> words;
+    std::vector<uchar> opcode, rd, ra, rb, rc;
+    std::vector<ushort> xo, imm;
+
+    std::size_t size() const;
+    void resize(std::size_t size);
+    DecodedInstruction get(std::size_t index) const;
+
+};
+
+// Decode size / 4 big-endian words starting at data. Trailing bytes are ignored.
+void decode_range(const uchar *data, std::size_t size, DecodedBlock& out);
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+#include "ppc/cfg.h"
+#include "ppc/code_section.h"
+#include "ppc/liveness.h"
+#include "ppc/symbol.h"
+
+namespace PPC {
+
+/**
+ * Function summaries kept between runs in one file, keyed by a hash of each function's bytes and of
+ * everything else its summary was worked out from. A missing, damaged or old file just starts empty.
+ */
+class SummaryCache {
+
+    std::string filename;
+    std::unordered_map<std::uint64_t, FunctionRegisters> entries;
+
+public:
+
+    // Bump when summaries change for the same code, so old files stop matching
+    static constexpr uint FORMAT_VERSION = 3;
+
+    explicit SummaryCache(const std::string& filename);
+
+    std::size_t size() const;
+    bool find(std::uint64_t key, FunctionRegisters& out) const;
+    void insert(std::uint64_t key, const FunctionRegisters& registers);
+    void clear();
+    // Write every entry back to the file, replacing it whole
+    void save() const;
+
+};
+
+/**
+ * How many strongly connected components a summarize worked out, and how many it took from a cache
+ */
+struct SummaryStats {
+    std::size_t computed, reused;
+};
+
+/**
+ * Every function of a set of code sections and the calls between them. Functions are numbered section
+ * by section in symbol order, and grouped into strongly connected components, the sets of functions that
+ * reach each other through calls. Components are numbered bottom up, each after everything it calls
+ * into. Only calls to a fixed address are followed. Calls between sections with a load address, such as
+ * a DOL's, are followed by virtual address. Code that's relocated, such as a REL's, has no address until
+ * its relocations are applied, so its calls are only followed within its own section.
+ */
+class CallGraph {
+
+    struct Function {
+        uint section;
+        uint symbol;
+    };
+
+    std::vector<CodeSection*> sections;
+    // Where each section is loaded, 0 if it isn't known, and the sections that are placed in address order
+    std::vector<ulong> addresses;
+    std::vector<uint> placed;
+    std::vector<Function> functions;
+    // Number of the first function of each section
+    std::vector<uint> first_function;
+    // Target of each call instruction of a function in order, in compressed rows, NONE if not followed
+    std::vector<uint> call_offsets, call_targets;
+    std::vector<uint> component_offsets, component_members, components;
+    std::vector<FunctionRegisters> summaries;
+    std::vector<std::uint64_t> keys;
+
+    void find_calls();
+    // Function starting where a call from section lands, NONE if there isn't one
+    uint function_at(uint section, ulong address) const;
+    void find_components();
+    ByteSpan code(uint function) const;
+    bool solve(uint component, const SummaryCache *cache);
+
+public:
+
+    static constexpr uint NONE = ~0u;
+
+    // The sections have to outlive the graph, their symbols and index are made if they aren't yet.
+    // addresses holds the load address of each section, 0 or left out for code that's relocated
+    explicit CallGraph(const std::vector<CodeSection*>& sections, const std::vector<ulong>& addresses = {});
+
+    std::size_t size() const;
+    uint function_of(uint section, std::size_t symbol) const;
+    Symbol& symbol(uint function) const;
+    // Target of each call the function makes, in instruction order
+    EdgeSpan calls(uint function) const;
+    // Symbol each instruction of the function calls, nullptr where it isn't a call that was followed
+    void callees(uint function, std::vector<Symbol*>& out) const;
+
+    std::size_t num_components() const;
+    uint component_of(uint function) const;
+    EdgeSpan members(uint component) const;
+
+    // Work out what every function reads, clobbers and returns, bottom up over the components on up to
+    // jobs threads, 0 for one per hardware thread. Components that don't call into each other are done
+    // at once, and each symbol's inputs and outputs are set from its summary. Components whose members
+    // are all in the cache are taken from there, after which the cache holds just this graph's entries
+    SummaryStats summarize(uint jobs = 1, SummaryCache *cache = nullptr);
+    // Only good after summarize
+    const FunctionRegisters& summary(uint function) const;
+    // What each call of the function does, as LivenessAnalyzer and SSAFunction take it
+    void call_summaries(uint function, std::vector<FunctionRegisters>& out) const;
+
+};
+
+}
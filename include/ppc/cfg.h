@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "ppc/decoder.h"
+
+namespace PPC {
+
+/**
+ * How control can leave one instruction of a function
+ */
+struct BranchFlow {
+    // Goes on to the next instruction, leaves the function, or calls out and comes back
+    bool next, exits, calls;
+    // Instruction in the function it can branch to, or -1
+    long target;
+};
+
+// Where control can go after the instruction at index, in a function count instructions long. A branch
+// out of the function or to a fixed address is a tail call, and exits
+BranchFlow branch_flow(const DecodedInstruction& inst, std::size_t index, std::size_t count);
+// Address a relative or absolute b or bc at address goes to
+int branch_address(const DecodedInstruction& inst, ulong address);
+
+/**
+ * A read-only run of block or value numbers, owned by the graph or IR they came from
+ */
+struct EdgeSpan {
+    const uint *data;
+    std::size_t length;
+
+    const uint *begin() const {
+        return data;
+    }
+    const uint *end() const {
+        return data + length;
+    }
+    std::size_t size() const {
+        return length;
+    }
+    bool empty() const {
+        return length == 0;
+    }
+    uint operator[](std::size_t index) const {
+        return data[index];
+    }
+};
+
+/**
+ * The basic blocks of one function and the edges between them. Blocks are ranges of instruction
+ * indices, and edges are kept in compressed rows, an offset per block into one shared array, so the
+ * whole graph is a handful of flat vectors. Block 0 is the entry. Building again reuses the vectors,
+ * so one graph run over every function of a section allocates next to nothing.
+ */
+class ControlFlowGraph {
+
+public:
+
+    static constexpr uint NONE = ~0u;
+
+    struct Block {
+        // Indices of the first and last instruction, inclusive
+        uint first, last;
+        // Whether control can leave the function from the end of this block
+        bool exits;
+    };
+
+private:
+
+    std::vector<Block> blocks;
+    std::vector<bool> leaders;
+    // Successors of block b are successor_edges[successor_offsets[b] .. successor_offsets[b + 1]]
+    std::vector<uint> successor_offsets, successor_edges;
+    std::vector<uint> predecessor_offsets, predecessor_edges;
+    // Blocks reachable from the entry in reverse postorder, and each block's place in it
+    std::vector<uint> order, order_number;
+    std::vector<uint> dominators;
+    std::vector<uint> stack;
+
+    void find_blocks(InstructionSpan instructions);
+    void link_blocks(InstructionSpan instructions);
+    void find_order();
+    void find_dominators();
+    uint intersect(uint first, uint second) const;
+
+public:
+
+    ControlFlowGraph();
+    explicit ControlFlowGraph(InstructionSpan instructions);
+
+    // Replace the graph with one for a new function
+    void build(InstructionSpan instructions);
+
+    std::size_t size() const;
+    const Block& operator[](uint block) const;
+    // Block holding an instruction index, which has to be in the function
+    uint block_of(std::size_t instruction) const;
+
+    EdgeSpan successors(uint block) const;
+    EdgeSpan predecessors(uint block) const;
+    // Reachable blocks, each after all of its predecessors except along back edges
+    EdgeSpan reverse_postorder() const;
+    bool reachable(uint block) const;
+
+    // Closest block every path from the entry to this one goes through. The entry is its own, and
+    // unreachable blocks have NONE
+    uint immediate_dominator(uint block) const;
+    bool dominates(uint dominator, uint block) const;
+
+};
+
+}
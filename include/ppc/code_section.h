@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "arena.h"
+#include "mapped_file.h"
+#include "ppc/decoder.h"
+#include "ppc/symbol.h"
+#include "ppc/symbol_index.h"
+
+namespace PPC {
+
+class SymbolMap;
+
+/**
+ * A run of code decoded once, up front. Symbol boundaries and their register inputs are worked out
+ * the first time they're asked for and then kept, so the disassembler and decompiler share one
+ * analysis of the section. The lazy parts aren't locked, make them before sharing across threads.
+ * The decoded instructions and symbol names all live in the section's arena, and go in one release
+ * when the section does.
+ */
+class CodeSection {
+
+    Arena arena;
+    ByteSpan code;
+    ulong base;
+    InstructionSpan decoded;
+    std::vector<Symbol> symbols;
+    SymbolIndex index;
+    bool symbols_made, inputs_made, index_made;
+
+public:
+
+    // base is the file offset of the first byte of code
+    explicit CodeSection(ByteSpan code, ulong base = 0);
+
+    ByteSpan bytes() const;
+    ulong get_base() const;
+    InstructionSpan get_instructions() const;
+    // Bytes held for this section's analysis
+    std::size_t memory_used() const;
+
+    std::vector<Symbol>& get_symbols();
+    // Symbols, with their input registers already generated on up to jobs threads
+    std::vector<Symbol>& get_symbols_with_inputs(uint jobs = 1);
+    // Index over the symbols, for finding them by address
+    const SymbolIndex& get_symbol_index();
+    // Rename the symbols map has a name for. address is where the section is loaded, since maps hold
+    // virtual addresses. The names are copied, the map needn't outlive the section
+    void name_symbols(const SymbolMap& map, ulong address);
+
+};
+
+}
@@ -1,58 +1,111 @@
 #pragma once
 
-#include <unordered_map>
-#include <set>
-#include <string>
+#include <array>
+#include <utility>
+#include <string_view>
+#include "types.h"
+#include "ppc/mnemonic.h"
 
 namespace PPC {
 
+	/**
+	 * Dense opcode table, indexed directly by the opcode bits. Missing entries are value initialized.
+	 */
+	template<std::size_t N, typename T = std::string_view>
+	class CodeTable {
+
+		std::array<T, N> entries {};
+
+	public:
+
+		template<std::size_t M>
+		constexpr CodeTable(const std::pair<ushort, T> (&init)[M]) {
+			for (std::size_t i = 0; i < M; ++i) {
+				entries[init[i].first] = init[i].second;
+			}
+		}
+
+		constexpr T operator[](std::size_t code) const {
+			return code < N ? entries[code] : T();
+		}
+
+		constexpr bool contains(std::size_t code) const {
+			return code < N && entries[code] != T();
+		}
+
+		static constexpr std::size_t size() {
+			return N;
+		}
+
+	};
+
+	template<std::size_t N>
+	class OpcodeSet {
+
+		std::array<bool, N> entries {};
+
+	public:
+
+		template<std::size_t M>
+		constexpr OpcodeSet(const ushort (&init)[M]) {
+			for (std::size_t i = 0; i < M; ++i) {
+				entries[init[i]] = true;
+			}
+		}
+
+		constexpr bool contains(std::size_t code) const {
+			return code < N && entries[code];
+		}
+
+	};
+
 	// Codes to names
 
-	static const std::unordered_map<ulong, std::string> primary_codes({{3, "twi"},{4, "UNKNOWN PAIRED-SINGLE"},{7, "mulli"},{8, "subfic"},{10, "cmpli"},{11, "cmpi"},{12, "addic"},{13, "addic."},
-		{14, "addi"},{15, "addis"},{16, "bc"},{17, "sc"},{18, "b"},{19, "UNKNOWN SPEC BRANCH"},{20, "rlwimi"},{21, "rlwinm"},{23, "rlwnm"},{24, "ori"},{25, "oris"},{26, "xori"},
-		{27, "xoris"},{28, "andi."},{29, "andis."},{31, "UNKNOWN MATH"},{32, "lwz"},{33, "lwzu"},{34, "lbz"},{35, "lbzu"},{36, "stw"},{37, "stwu"},{38, "stb"},{39, "stbu"},
-		{40, "lhz"},{41, "lhzu"},{42, "lha"},{43, "lhau"},{44, "sth"},{45, "sthu"},{46, "lmw"},{47, "smtw"},{48, "lfs"},{49, "lfsu"},{50, "lfd"},{51, "lfdu"},{52, "stfs"},
-		{53, "stfsu"},{54, "stfd"},{55, "stfdu"},{56, "ps_l"},{57, "ps_lu"},{59, "UNKNOWN FLOATING SINGLE"},{60, "ps_st"},{61, "ps_stu"},{63, "UNKNOWN FLOATING DOUBLE"}
+	inline constexpr CodeTable<64, Mnemonic> primary_codes({{3, Mnemonic::TWI},{4, Mnemonic::UNKNOWN_PAIRED_SINGLE},{7, Mnemonic::MULLI},{8, Mnemonic::SUBFIC},{10, Mnemonic::CMPLI},{11, Mnemonic::CMPI},{12, Mnemonic::ADDIC},{13, Mnemonic::ADDIC_DOT},
+		{14, Mnemonic::ADDI},{15, Mnemonic::ADDIS},{16, Mnemonic::BC},{17, Mnemonic::SC},{18, Mnemonic::B},{19, Mnemonic::UNKNOWN_SPEC_BRANCH},{20, Mnemonic::RLWIMI},{21, Mnemonic::RLWINM},{23, Mnemonic::RLWNM},{24, Mnemonic::ORI},{25, Mnemonic::ORIS},{26, Mnemonic::XORI},
+		{27, Mnemonic::XORIS},{28, Mnemonic::ANDI_DOT},{29, Mnemonic::ANDIS_DOT},{31, Mnemonic::UNKNOWN_MATH},{32, Mnemonic::LWZ},{33, Mnemonic::LWZU},{34, Mnemonic::LBZ},{35, Mnemonic::LBZU},{36, Mnemonic::STW},{37, Mnemonic::STWU},{38, Mnemonic::STB},{39, Mnemonic::STBU},
+		{40, Mnemonic::LHZ},{41, Mnemonic::LHZU},{42, Mnemonic::LHA},{43, Mnemonic::LHAU},{44, Mnemonic::STH},{45, Mnemonic::STHU},{46, Mnemonic::LMW},{47, Mnemonic::SMTW},{48, Mnemonic::LFS},{49, Mnemonic::LFSU},{50, Mnemonic::LFD},{51, Mnemonic::LFDU},{52, Mnemonic::STFS},
+		{53, Mnemonic::STFSU},{54, Mnemonic::STFD},{55, Mnemonic::STFDU},{56, Mnemonic::PS_L},{57, Mnemonic::PS_LU},{59, Mnemonic::UNKNOWN_FLOATING_SINGLE},{60, Mnemonic::PS_ST},{61, Mnemonic::PS_STU},{63, Mnemonic::UNKNOWN_FLOATING_DOUBLE}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_codes_ps({
-		{0, "ps_cmp"},{6, "ps_lx"},{7, "ps_stx"},{8, "UNKNOWN ABS/NEGATE"},{10, "ps_sum0"},{11, "ps_sum1"},{12, "ps_muls0"},{13, "ps_muls1"},{14, "ps_madds0"},{15, "ps_madds1"},{16, "ps_merge"},
-		{18, "ps_div"},{20, "ps_sub"},{21, "ps_add"},{23, "ps_sel"},{24, "ps_res"},{25, "ps_mul"},{26, "ps_rsqrte"},{28, "ps_msub"},{29, "ps_madd"},{30, "ps_nmsub"},
-		{31, "ps_nmadd"}, {40, "ps_neg"}, {72, "ps_mr"}, {136, "ps_nabs"}, {264, "ps_abs"}, {1014, "dcbz_l"}
+	inline constexpr CodeTable<1024, Mnemonic> secondary_codes_ps({
+		{0, Mnemonic::PS_CMP},{6, Mnemonic::PS_LX},{7, Mnemonic::PS_STX},{8, Mnemonic::UNKNOWN_ABS_NEGATE},{10, Mnemonic::PS_SUM0},{11, Mnemonic::PS_SUM1},{12, Mnemonic::PS_MULS0},{13, Mnemonic::PS_MULS1},{14, Mnemonic::PS_MADDS0},{15, Mnemonic::PS_MADDS1},{16, Mnemonic::PS_MERGE},
+		{18, Mnemonic::PS_DIV},{20, Mnemonic::PS_SUB},{21, Mnemonic::PS_ADD},{23, Mnemonic::PS_SEL},{24, Mnemonic::PS_RES},{25, Mnemonic::PS_MUL},{26, Mnemonic::PS_RSQRTE},{28, Mnemonic::PS_MSUB},{29, Mnemonic::PS_MADD},{30, Mnemonic::PS_NMSUB},
+		{31, Mnemonic::PS_NMADD}, {40, Mnemonic::PS_NEG}, {72, Mnemonic::PS_MR}, {136, Mnemonic::PS_NABS}, {264, Mnemonic::PS_ABS}, {1014, Mnemonic::DCBZ_L}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_codes_sb({
-		{0, "mcrf"},{16, "bclr"},{33, "crnor"},{50 ,"rfi"},{129, "crandc"},{150, "isync"},{193, "crxor"},{225, "crnand"},{257, "crand"},{289, "creqv"},
-		{417, "crorc"},{449, "cror"},{528, "bcctr"}
+	inline constexpr CodeTable<1024, Mnemonic> secondary_codes_sb({
+		{0, Mnemonic::MCRF},{16, Mnemonic::BCLR},{33, Mnemonic::CRNOR},{50, Mnemonic::RFI},{129, Mnemonic::CRANDC},{150, Mnemonic::ISYNC},{193, Mnemonic::CRXOR},{225, Mnemonic::CRNAND},{257, Mnemonic::CRAND},{289, Mnemonic::CREQV},
+		{417, Mnemonic::CRORC},{449, Mnemonic::CROR},{528, Mnemonic::BCCTR}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_codes_math({
-		{0, "cmp"},{4, "tw"},{8, "subfc"},{10, "addc"},{11, "mulhwu"},{19, "mfcr"},{20, "lwarx"},{23, "lwzx"},{24, "slw"},{26, "cntlzw"},{28, "and"},{32, "cmpl"},
-		{40, "subf"},{54, "dcbst"},{55, "lwzux"},{60, "andc"},{75, "mulhw"},{83, "mfmsr"},{86, "dcbf"},{87, "lbzx"},{104, "neg"},{119, "lbzux"},{124, "nor"},
-		{136, "subfe"},{138, "adde"},{144, "mtcrf"},{146, "mtmsr"},{150, "stwcx"},{151, "stwx"},{183, "stwux"},{200, "subfze"},{202, "addze"},{210, "mtsr"},
-		{215, "stbx"},{232, "subfme"},{234, "addme"},{235, "mullw"},{242, "mtsrin"},{246, "dcbtst"},{247, "stbux"},{266, "add"},{278, "dcbt"},{279, "lhzx"},
-		{284, "eqv"},{306, "tlbie"},{310, "eciwx"},{311, "lhzux"},{316, "xor"},{339, "mfspr"},{343, "lhax"},{370, "tlbia"},{371, "mftb"},{375, "lhaux"},{407, "sthx"},
-		{412, "orc"},{438, "ecowx"},{439, "sthux"},{444, "or"},{459, "divwu"},{467, "mtspr"},{470, "dcbi"},{476, "nand"},{491, "divw"},{512, "mcrxr"},{520, "subfco"},
-		{522, "addco"},{533, "lswx"},{534, "lwbrx"},{535, "lfsx"},{536, "srw"},{552, "subfo"},{566, "tlbsync"},{567, "lfsux"},{595, "mfsr"},{597, "lswi"},
-		{598, "sync"},{599, "lfdx"},{616, "nego"},{631, "lfdux"},{648, "subfeo"},{650, "addeo"},{661, "stswx"},{662, "stwbrx"},{663, "stfsx"},{695, "stfsux"},
-		{712, "subfzeo"},{714, "addzeo"},{725, "stswi"},{727, "stfdx"},{744, "subfmeo"},{746, "addmeo"},{747, "mullwo"},{758, "dcba"},{759, "stfdux"},{778, "addo"},
-		{790, "lhbrx"},{792, "sraw"},{824, "srawi"},{854, "eieio"},{918, "sthbrx"},{922, "extsh"},{954, "extsb"},{971, "divwuo"},{982, "icbi"},{983, "stfiwx"},
-		{1003, "divwo"},{1014, "dcbz"}
+	inline constexpr CodeTable<1024, Mnemonic> secondary_codes_math({
+		{0, Mnemonic::CMP},{4, Mnemonic::TW},{8, Mnemonic::SUBFC},{10, Mnemonic::ADDC},{11, Mnemonic::MULHWU},{19, Mnemonic::MFCR},{20, Mnemonic::LWARX},{23, Mnemonic::LWZX},{24, Mnemonic::SLW},{26, Mnemonic::CNTLZW},{28, Mnemonic::AND},{32, Mnemonic::CMPL},
+		{40, Mnemonic::SUBF},{54, Mnemonic::DCBST},{55, Mnemonic::LWZUX},{60, Mnemonic::ANDC},{75, Mnemonic::MULHW},{83, Mnemonic::MFMSR},{86, Mnemonic::DCBF},{87, Mnemonic::LBZX},{104, Mnemonic::NEG},{119, Mnemonic::LBZUX},{124, Mnemonic::NOR},
+		{136, Mnemonic::SUBFE},{138, Mnemonic::ADDE},{144, Mnemonic::MTCRF},{146, Mnemonic::MTMSR},{150, Mnemonic::STWCX},{151, Mnemonic::STWX},{183, Mnemonic::STWUX},{200, Mnemonic::SUBFZE},{202, Mnemonic::ADDZE},{210, Mnemonic::MTSR},
+		{215, Mnemonic::STBX},{232, Mnemonic::SUBFME},{234, Mnemonic::ADDME},{235, Mnemonic::MULLW},{242, Mnemonic::MTSRIN},{246, Mnemonic::DCBTST},{247, Mnemonic::STBUX},{266, Mnemonic::ADD},{278, Mnemonic::DCBT},{279, Mnemonic::LHZX},
+		{284, Mnemonic::EQV},{306, Mnemonic::TLBIE},{310, Mnemonic::ECIWX},{311, Mnemonic::LHZUX},{316, Mnemonic::XOR},{339, Mnemonic::MFSPR},{343, Mnemonic::LHAX},{370, Mnemonic::TLBIA},{371, Mnemonic::MFTB},{375, Mnemonic::LHAUX},{407, Mnemonic::STHX},
+		{412, Mnemonic::ORC},{438, Mnemonic::ECOWX},{439, Mnemonic::STHUX},{444, Mnemonic::OR},{459, Mnemonic::DIVWU},{467, Mnemonic::MTSPR},{470, Mnemonic::DCBI},{476, Mnemonic::NAND},{491, Mnemonic::DIVW},{512, Mnemonic::MCRXR},{520, Mnemonic::SUBFCO},
+		{522, Mnemonic::ADDCO},{533, Mnemonic::LSWX},{534, Mnemonic::LWBRX},{535, Mnemonic::LFSX},{536, Mnemonic::SRW},{552, Mnemonic::SUBFO},{566, Mnemonic::TLBSYNC},{567, Mnemonic::LFSUX},{595, Mnemonic::MFSR},{597, Mnemonic::LSWI},
+		{598, Mnemonic::SYNC},{599, Mnemonic::LFDX},{616, Mnemonic::NEGO},{631, Mnemonic::LFDUX},{648, Mnemonic::SUBFEO},{650, Mnemonic::ADDEO},{661, Mnemonic::STSWX},{662, Mnemonic::STWBRX},{663, Mnemonic::STFSX},{695, Mnemonic::STFSUX},
+		{712, Mnemonic::SUBFZEO},{714, Mnemonic::ADDZEO},{725, Mnemonic::STSWI},{727, Mnemonic::STFDX},{744, Mnemonic::SUBFMEO},{746, Mnemonic::ADDMEO},{747, Mnemonic::MULLWO},{758, Mnemonic::DCBA},{759, Mnemonic::STFDUX},{778, Mnemonic::ADDO},
+		{790, Mnemonic::LHBRX},{792, Mnemonic::SRAW},{824, Mnemonic::SRAWI},{854, Mnemonic::EIEIO},{918, Mnemonic::STHBRX},{922, Mnemonic::EXTSH},{954, Mnemonic::EXTSB},{971, Mnemonic::DIVWUO},{982, Mnemonic::ICBI},{983, Mnemonic::STFIWX},
+		{1003, Mnemonic::DIVWO},{1014, Mnemonic::DCBZ}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_codes_float({
-		{18, "fdivs"},{20, "fsubs"},{21, "fadds"},{22, "fsqrts"},{24, "fres"},{25, "fmuls"},{28, "fmsubs"},{29, "fmadds"},{30, "fnmsubs"},{31, "fnmadds"}
+	inline constexpr CodeTable<32, Mnemonic> secondary_codes_float({
+		{18, Mnemonic::FDIVS},{20, Mnemonic::FSUBS},{21, Mnemonic::FADDS},{22, Mnemonic::FSQRTS},{24, Mnemonic::FRES},{25, Mnemonic::FMULS},{28, Mnemonic::FMSUBS},{29, Mnemonic::FMADDS},{30, Mnemonic::FNMSUBS},{31, Mnemonic::FNMADDS}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_codes_double({
-		{0, "fcmpu"},{12, "frsp"},{14, "fctiw"},{15, "fctiwz"},{18, "fdiv"},{20, "fsub"},{21, "fadd"},{22, "fsqrt"},{23, "fsel"},{25, "fmul"},{26, "frsqrte"},
-		{28, "fmsub"},{29, "fmadd"},{30, "fnmsub"},{31, "fnmadd"},{32, "fcmpo"},{38, "mtfsb1"},{40, "fneg"},{64, "mcrfs"},{70, "mtfsb0"},{72, "fmr"},
-		{134, "mtfsfi"},{136, "fnabs"},{264, "fabs"},{583, "mffs"},{711, "mtfsf"}
+	inline constexpr CodeTable<1024, Mnemonic> secondary_codes_double({
+		{0, Mnemonic::FCMPU},{12, Mnemonic::FRSP},{14, Mnemonic::FCTIW},{15, Mnemonic::FCTIWZ},{18, Mnemonic::FDIV},{20, Mnemonic::FSUB},{21, Mnemonic::FADD},{22, Mnemonic::FSQRT},{23, Mnemonic::FSEL},{25, Mnemonic::FMUL},{26, Mnemonic::FRSQRTE},
+		{28, Mnemonic::FMSUB},{29, Mnemonic::FMADD},{30, Mnemonic::FNMSUB},{31, Mnemonic::FNMADD},{32, Mnemonic::FCMPO},{38, Mnemonic::MTFSB1},{40, Mnemonic::FNEG},{64, Mnemonic::MCRFS},{70, Mnemonic::MTFSB0},{72, Mnemonic::FMR},
+		{134, Mnemonic::MTFSFI},{136, Mnemonic::FNABS},{264, Mnemonic::FABS},{583, Mnemonic::MFFS},{711, Mnemonic::MTFSF}
 		});
 
 	// Codes to patterns
 
-	static const std::unordered_map<ulong, std::string> primary_patterns({
+	inline constexpr CodeTable<64> primary_patterns({
 		{3, "{b0:X6,10}, r{b0:11,15}, {b0:sX16,31}"},{7, "r{b0:6,10}, r{b0:11,15}, {b0:sX16,31}"},{8, "r{b0:6,10}, r{b0:11,15}, {b0:sX16,31}"},{13, "r{b0:6,10}, r{b0:11,15}, {b0:sX16,31}"},{14, "r{b0:6,10}, r{b0:11,15}, {b0:sX16,31}"},
 		{16, "{b0:6,10}, {b0:11,15}, {b0:X16,29}"},{17, "{b0:}"},{18, "{b0:X6,29}"},{19, "crb{b0:6,10}, crb{b0:11,15}, crb{b0:16,20}"},{20, "r{b0:11,15}, r{b0:6,10}, {b0:X16,20}, {b0:X21,25}, {b0:X26,30}"},
 		{21, "r{b0:11,15}, r{b0:6,10}, {b0:X16,20}, {b0:X21,25}, {b0:X26,30}"},{23, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}, {b0:X21,25}, {b0:X26,30}"},{24, "r{b0:11,15}, r{b0:6,10}, {b0:X16,31}"},
@@ -66,7 +119,7 @@ namespace PPC {
 		{60, "r{b0:11,15}, r{b0:6,10}, W{b0:16,19}, {b0:X20,31}"},{61, "r{b0:11,15}, r{b0:6,10}, W{b0:16,19}, {b0:X20,31}"}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_patterns_ps({
+	inline constexpr CodeTable<1024> secondary_patterns_ps({
 		{0, "crf{b0:6,8}, r{b0:11,15}, r{b0:16,20}"},{6, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}, W{b0:21,24}"},{7, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}, W{b0:21,24}"},{8, "r{b0:6,10}, r{b0:16,20}"},{10, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}, r{b0:21,25}"},
 		{11, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}, r{b0:21,25}"},{12, "r{b0:6,10}, r{b0:11,15}, r{b0:21,25}"},{13, "r{b0:6,10}, r{b0:11,15}, r{b0:21,25}"},{14, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}, r{b0:21,25}"},
 		{15, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}, r{b0:21,25}"},{16, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}"},{18, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}"},{20, "r{b0:6,10}, r{b0:11,15}, r{b0:16,20}"},
@@ -75,11 +128,11 @@ namespace PPC {
         {40, "fr{b0:6,10}, fr{b0:16,20}"},{72, "fr{b0:6,10}, fr{b0:16,20}"},{136, "fr{b0:6,10}, fr{b0:16,20}"},{264, "fr{b0:6,10}, fr{b0:16,20}"},{1014, "r{b0:11,15}, r{b0:16,20}"}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_patterns_sb({
+	inline constexpr CodeTable<1024> secondary_patterns_sb({
 		{0, "crf{b0:6,8}, crf{b0:11,13}"},{50, "{b0:}"},{150, "{b0:}"}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_patterns_math({
+	inline constexpr CodeTable<1024> secondary_patterns_math({
 		{4, "{b0:6,10}, r{b0:11,15}, r{b0:16,20}"},{19, "r{b0:6,10}"},{24, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}"},{26, "r{b0:6,10}, r{b0:11,15}"},{28, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}"},{54, "r{b0:11,15}, r{b0:16,20}"},
 		{60, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}"},{83, "r{b0:6,10}"},{86, "r{b0:11,15}, r{b0:16,20}"},{104, "r{b0:6,10}, r{b0:11,15}"},{124, "r{b0:11,15}, r{b0:6,10}, r{b0:16,20}"},{146, "r{b0:6,10}"},{200, "r{b0:6,10}, r{b0:11,15}"},
 		{202, "r{b0:6,10}, r{b0:11,15}"},{210, "{b0:12,15}, r{b0:6,10}"},{232, "r{b0:6,10}, r{b0:11,15}"},{234, "r{b0:6,10}, r{b0:11,15}"},{242, "r{b0:6,10}, r{b0:16,20}"},{246, "r{b0:11,15}, r{b0:16,20}"},
@@ -92,12 +145,12 @@ namespace PPC {
 		{922, "r{b0:11,15}, r{b0:6,10}"},{954, "r{b0:11,15}, r{b0:6,10}"},{982, "r{b0:11,15}, r{b0:16,20}"},{983, "fr{b0:6,10}, r{b0:11,15}, r{b0:16,20}"},{1014, "r{b0:11,15}, r{b0:16,20}"}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_patterns_float({
+	inline constexpr CodeTable<32> secondary_patterns_float({
 		{18, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},{20, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},{21, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},{22, "fr{b0:6,10}, fr{b0:16,20}"},{24, "fr{b0:6,10}, fr{b0:16,20}"},
 		{25, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:21,25}"}
 		});
 
-	static const std::unordered_map<ulong, std::string> secondary_patterns_double({
+	inline constexpr CodeTable<1024> secondary_patterns_double({
 		{0, "crf{b0:6,8}, fr{b0:11,15}, fr{b0:16,20}"},{12, "fr{b0:6,10}, fr{b0:16,20}"},{14, "fr{b0:6,10}, fr{b0:16,20}"},{15, "fr{b0:6,10}, fr{b0:16,20}"},{18, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},
 		{20, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},{21, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:16,20}"},{22, "fr{b0:6,10}, fr{b0:16,20}"},{23, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:21,25}, fr{b0:16,20}"},
 		{25, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:21,25}"},{26, "fr{b0:6,10}, fr{b0:16,20}"},{28, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:21,25}, fr{b0:16,20}"},{29, "fr{b0:6,10}, fr{b0:11,15}, fr{b0:21,25}, fr{b0:16,20}"},
@@ -106,13 +159,124 @@ namespace PPC {
 		{264, "fr{b0:6,10}, fr{b0:16,20}"},{583, "fr{b0:6,10}, fr{b0:16,20}"},{711, "{b0:X7,14}, fr{b0:16,20}"}
 		});
 
+	// Patterns for forms that are special cased by the decoder. {spr} is the split SPR field of mfspr/mtspr.
+
+	inline constexpr std::string_view pattern_none = "{b0:}";
+	inline constexpr std::string_view pattern_unknown = "FIX ME";
+	inline constexpr std::string_view pattern_cmp_imm_word = "crf{b0:6,8}, r{b0:11,15}, {b0:X16,31}";
+	inline constexpr std::string_view pattern_cmp_imm = "crf{b0:6,8}, {b0:10,10}, r{b0:11,15}, {b0:X16,31}";
+	inline constexpr std::string_view pattern_cmp_word = "crf{b0:6,8}, r{b0:11,15}, r{b0:16,20}";
+	inline constexpr std::string_view pattern_cmp = "crf{b0:6,8}, {b0:10,10}, r{b0:11,15}, r{b0:16,20}";
+	inline constexpr std::string_view pattern_add_imm = "r{b0:6,10}, r{b0:11,15}, {b0:sX16,31}";
+	inline constexpr std::string_view pattern_sub_imm = "r{b0:6,10}, r{b0:11,15}, {b0:aX16,31}";
+	inline constexpr std::string_view pattern_branch_cond = "{b0:X16,29}";
+	inline constexpr std::string_view pattern_branch_reg = "{b0:6,10}, {b0:11,15}";
+	inline constexpr std::string_view pattern_move = "r{b0:11,15}, r{b0:6,10}";
+	inline constexpr std::string_view pattern_single = "r{b0:6,10}";
+	inline constexpr std::string_view pattern_mtcrf = "{b0:X12,19}, r{b0:6,10}";
+	inline constexpr std::string_view pattern_from_spr = "{spr}, r{b0:6,10}";
+	inline constexpr std::string_view pattern_to_spr = "r{b0:6,10}, {spr}";
+
+	// Codes to register roles. D, A, B and C are the register fields at bits 6-10, 11-15, 16-20 and 21-25
+
+	enum RegisterRole : uint {
+		NO_ROLES = 0,
+		D_READ = 1u << 0, D_WRITE = 1u << 1, D_READ_FLOAT = 1u << 2, D_WRITE_FLOAT = 1u << 3,
+		// A_BASE is an rA that reads as 0 when it's r0, A_UPDATE an rA that's read and then written back
+		A_READ = 1u << 4, A_BASE = 1u << 5, A_WRITE = 1u << 6, A_UPDATE = A_READ | A_WRITE, A_READ_FLOAT = 1u << 7,
+		B_READ = 1u << 8, B_READ_FLOAT = 1u << 9, C_READ_FLOAT = 1u << 10,
+		// Condition register fields at bits 6-8 and 11-13, and condition bits in D, A and B
+		D_WRITE_FIELD = 1u << 11, A_READ_FIELD = 1u << 12, D_WRITE_BIT = 1u << 13, AB_READ_BITS = 1u << 14,
+		// The BI field of a conditional branch, unless BO ignores the condition
+		READ_BI = 1u << 15,
+		// Rc sets cr0, or cr1 for floating point. Some codes always set cr0
+		RECORD = 1u << 16, WRITE_CR0 = 1u << 17,
+		// mfcr and mtcrf, the latter only the fields in its CRM mask
+		READ_CR = 1u << 18, WRITE_CRM = 1u << 19,
+		// lmw and stmw, rD through r31
+		WRITE_MULTIPLE = 1u << 20, READ_MULTIPLE = 1u << 21,
+
+		ARITH = D_WRITE | A_READ | B_READ | RECORD,
+		UNARY = D_WRITE | A_READ | RECORD,
+		LOGIC = A_WRITE | D_READ | B_READ | RECORD,
+		LOGIC_UNARY = A_WRITE | D_READ | RECORD,
+		CACHE = A_BASE | B_READ,
+		LOAD = D_WRITE | A_BASE, LOAD_UPDATE = D_WRITE | A_UPDATE,
+		STORE = D_READ | A_BASE, STORE_UPDATE = D_READ | A_UPDATE,
+		LOAD_INDEXED = LOAD | B_READ, LOAD_UPDATE_INDEXED = LOAD_UPDATE | B_READ,
+		STORE_INDEXED = STORE | B_READ, STORE_UPDATE_INDEXED = STORE_UPDATE | B_READ,
+		LOAD_FLOAT = D_WRITE_FLOAT | A_BASE, LOAD_FLOAT_UPDATE = D_WRITE_FLOAT | A_UPDATE,
+		STORE_FLOAT = D_READ_FLOAT | A_BASE, STORE_FLOAT_UPDATE = D_READ_FLOAT | A_UPDATE,
+		FLOAT_AB = D_WRITE_FLOAT | A_READ_FLOAT | B_READ_FLOAT | RECORD,
+		FLOAT_AC = D_WRITE_FLOAT | A_READ_FLOAT | C_READ_FLOAT | RECORD,
+		FLOAT_ABC = FLOAT_AB | C_READ_FLOAT,
+		FLOAT_B = D_WRITE_FLOAT | B_READ_FLOAT | RECORD,
+		FLOAT_COMPARE = D_WRITE_FIELD | A_READ_FLOAT | B_READ_FLOAT,
+		CR_LOGIC = D_WRITE_BIT | AB_READ_BITS
+	};
+
+	// Paired single loads and stores pick their update form with bit 25, it's added by the lookup
+	inline constexpr CodeTable<64, uint> primary_roles({
+		{3, A_READ},{7, D_WRITE | A_READ},{8, D_WRITE | A_READ},{10, D_WRITE_FIELD | A_READ},{11, D_WRITE_FIELD | A_READ},{12, D_WRITE | A_READ},
+		{13, D_WRITE | A_READ | WRITE_CR0},{14, D_WRITE | A_BASE},{15, D_WRITE | A_BASE},{16, READ_BI},{20, LOGIC_UNARY | A_READ},
+		{21, LOGIC_UNARY},{23, LOGIC},{24, A_WRITE | D_READ},{25, A_WRITE | D_READ},{26, A_WRITE | D_READ},{27, A_WRITE | D_READ},
+		{28, A_WRITE | D_READ | WRITE_CR0},{29, A_WRITE | D_READ | WRITE_CR0},{32, LOAD},{33, LOAD_UPDATE},{34, LOAD},{35, LOAD_UPDATE},
+		{36, STORE},{37, STORE_UPDATE},{38, STORE},{39, STORE_UPDATE},{40, LOAD},{41, LOAD_UPDATE},{42, LOAD},{43, LOAD_UPDATE},
+		{44, STORE},{45, STORE_UPDATE},{46, WRITE_MULTIPLE | A_BASE},{47, READ_MULTIPLE | A_BASE},{48, LOAD_FLOAT},{49, LOAD_FLOAT_UPDATE},
+		{50, LOAD_FLOAT},{51, LOAD_FLOAT_UPDATE},{52, STORE_FLOAT},{53, STORE_FLOAT_UPDATE},{54, STORE_FLOAT},{55, STORE_FLOAT_UPDATE},
+		{56, LOAD_FLOAT},{57, LOAD_FLOAT_UPDATE},{60, STORE_FLOAT},{61, STORE_FLOAT_UPDATE}
+		});
+
+	inline constexpr CodeTable<1024, uint> secondary_roles_ps({
+		{0, FLOAT_COMPARE},{6, LOAD_FLOAT | B_READ},{7, STORE_FLOAT | B_READ},{8, FLOAT_B},{10, FLOAT_ABC},{11, FLOAT_ABC},{12, FLOAT_AC},
+		{13, FLOAT_AC},{14, FLOAT_ABC},{15, FLOAT_ABC},{16, FLOAT_AB},{18, FLOAT_AB},{20, FLOAT_AB},{21, FLOAT_AB},{23, FLOAT_ABC},
+		{24, FLOAT_B},{25, FLOAT_AC},{26, FLOAT_B},{28, FLOAT_ABC},{29, FLOAT_ABC},{30, FLOAT_ABC},{31, FLOAT_ABC},{40, FLOAT_B},
+		{72, FLOAT_B},{136, FLOAT_B},{264, FLOAT_B},{1014, CACHE}
+		});
+
+	inline constexpr CodeTable<1024, uint> secondary_roles_sb({
+		{0, D_WRITE_FIELD | A_READ_FIELD},{16, READ_BI},{33, CR_LOGIC},{129, CR_LOGIC},{193, CR_LOGIC},{225, CR_LOGIC},{257, CR_LOGIC},
+		{289, CR_LOGIC},{417, CR_LOGIC},{449, CR_LOGIC},{528, READ_BI}
+		});
+
+	inline constexpr CodeTable<1024, uint> secondary_roles_math({
+		{0, D_WRITE_FIELD | A_READ | B_READ},{4, A_READ | B_READ},{8, ARITH},{10, ARITH},{11, ARITH},{19, D_WRITE | READ_CR},
+		{20, LOAD_INDEXED},{23, LOAD_INDEXED},{24, LOGIC},{26, LOGIC_UNARY},{28, LOGIC},{32, D_WRITE_FIELD | A_READ | B_READ},{40, ARITH},
+		{54, CACHE},{55, LOAD_UPDATE_INDEXED},{60, LOGIC},{75, ARITH},{83, D_WRITE},{86, CACHE},{87, LOAD_INDEXED},{104, UNARY},
+		{119, LOAD_UPDATE_INDEXED},{124, LOGIC},{136, ARITH},{138, ARITH},{144, D_READ | WRITE_CRM},{146, D_READ},
+		{150, STORE_INDEXED | WRITE_CR0},{151, STORE_INDEXED},{183, STORE_UPDATE_INDEXED},{200, UNARY},{202, UNARY},{210, D_READ},
+		{215, STORE_INDEXED},{232, UNARY},{234, UNARY},{235, ARITH},{242, D_READ | B_READ},{246, CACHE},{247, STORE_UPDATE_INDEXED},
+		{266, ARITH},{278, CACHE},{279, LOAD_INDEXED},{284, LOGIC},{306, B_READ},{310, LOAD_INDEXED},{311, LOAD_UPDATE_INDEXED},
+		{316, LOGIC},{339, D_WRITE},{343, LOAD_INDEXED},{371, D_WRITE},{375, LOAD_UPDATE_INDEXED},{407, STORE_INDEXED},{412, LOGIC},
+		{438, STORE_INDEXED},{439, STORE_UPDATE_INDEXED},{444, LOGIC},{459, ARITH},{467, D_READ},{470, CACHE},{476, LOGIC},{491, ARITH},
+		{512, D_WRITE_FIELD},{520, ARITH},{522, ARITH},{533, LOAD_INDEXED},{534, LOAD_INDEXED},{535, LOAD_FLOAT | B_READ},{536, LOGIC},
+		{552, ARITH},{567, LOAD_FLOAT_UPDATE | B_READ},{595, D_WRITE},{597, LOAD},{599, LOAD_FLOAT | B_READ},{616, UNARY},
+		{631, LOAD_FLOAT_UPDATE | B_READ},{648, ARITH},{650, ARITH},{661, STORE_INDEXED},{662, STORE_INDEXED},{663, STORE_FLOAT | B_READ},
+		{695, STORE_FLOAT_UPDATE | B_READ},{712, UNARY},{714, UNARY},{725, STORE},{727, STORE_FLOAT | B_READ},{744, UNARY},{746, UNARY},
+		{747, ARITH},{758, CACHE},{759, STORE_FLOAT_UPDATE | B_READ},{778, ARITH},{790, LOAD_INDEXED},{792, LOGIC},{824, LOGIC_UNARY},
+		{918, STORE_INDEXED},{922, LOGIC_UNARY},{954, LOGIC_UNARY},{971, ARITH},{982, CACHE},{983, STORE_FLOAT | B_READ},{1003, ARITH},
+		{1014, CACHE}
+		});
+
+	inline constexpr CodeTable<32, uint> secondary_roles_float({
+		{18, FLOAT_AB},{20, FLOAT_AB},{21, FLOAT_AB},{22, FLOAT_B},{24, FLOAT_B},{25, FLOAT_AC},{28, FLOAT_ABC},{29, FLOAT_ABC},
+		{30, FLOAT_ABC},{31, FLOAT_ABC}
+		});
+
+	inline constexpr CodeTable<1024, uint> secondary_roles_double({
+		{0, FLOAT_COMPARE},{12, FLOAT_B},{14, FLOAT_B},{15, FLOAT_B},{18, FLOAT_AB},{20, FLOAT_AB},{21, FLOAT_AB},{22, FLOAT_B},
+		{23, FLOAT_ABC},{25, FLOAT_AC},{26, FLOAT_B},{28, FLOAT_ABC},{29, FLOAT_ABC},{30, FLOAT_ABC},{31, FLOAT_ABC},
+		{32, FLOAT_COMPARE},{38, RECORD},{40, FLOAT_B},{64, D_WRITE_FIELD},{70, RECORD},{72, FLOAT_B},{134, RECORD},{136, FLOAT_B},
+		{264, FLOAT_B},{583, D_WRITE_FLOAT | RECORD},{711, B_READ_FLOAT | RECORD}
+		});
+
 	// Codes without destination register
 
-	static const std::set<ulong> primary_missing_dest({3, 16, 17, 18, 19, 36, 37, 38, 39, 44, 45, 47, 52, 53, 54, 55});
+	inline constexpr OpcodeSet<64> primary_missing_dest({3, 16, 17, 18, 19, 36, 37, 38, 39, 44, 45, 47, 52, 53, 54, 55});
 
-	static const std::set<ulong> secondary_missing_dest_math({4, 54, 86, 144, 146, 150, 151, 183, 210, 215, 242, 246, 247, 278, 306, 370, 407, 438, 439, 467, 470,
+	inline constexpr OpcodeSet<1024> secondary_missing_dest_math({4, 54, 86, 144, 146, 150, 151, 183, 210, 215, 242, 246, 247, 278, 306, 370, 407, 438, 439, 467, 470,
 															566, 598, 661, 662, 663, 695, 725, 727, 758, 759, 854, 918, 982, 983, 1014});
 
-	static const std::set<ulong> secondary_missing_dest_double({711});
+	inline constexpr OpcodeSet<1024> secondary_missing_dest_double({711});
 
 }
\ No newline at end of file
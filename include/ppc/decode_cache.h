@@ -0,0 +1,42 @@
+#pragma once
+
+#include "types.h"
+#include "ppc/decoder.h"
+#include "ppc/operands.h"
+
+namespace PPC {
+
+// A decoded word along with its formatted operand text
+struct CachedInstruction {
+
+    DecodedInstruction decoded;
+    bool valid;
+    uchar operand_length;
+    char operands[MAX_OPERAND_TEXT];
+
+};
+
+struct CacheStats {
+
+    ulong hits;
+    ulong misses;
+
+};
+
+/**
+ * Game code repeats the same few thousand words over and over, so decoding and operand formatting
+ * can be cached by the raw word. The cache is a direct-mapped table per thread, so lookups take no
+ * locks. It is off by default, while off decode_cached decodes every call and counts nothing.
+ */
+void set_decode_cache(bool enabled);
+bool decode_cache_enabled();
+
+const CachedInstruction& decode_cached(uint word);
+// Same as above, but skips decoding on a miss
+const CachedInstruction& decode_cached(const DecodedInstruction& inst);
+
+// Counts from this thread, plus every thread that has already exited
+CacheStats decode_cache_stats();
+void reset_decode_cache_stats();
+
+}
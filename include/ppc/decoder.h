@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types.h"
+#include "ppc/mnemonic.h"
+
+namespace PPC {
+
+// Bits are numbered like the PPC manuals, 0 is the most significant bit of the word
+constexpr uint get_bits(uint word, uint start, uint end) {
+    return (word >> (31 - end)) & (uint)((1ul << (end - start + 1)) - 1);
+}
+
+constexpr bool get_bit(uint word, uint bit) {
+    return (word >> (31 - bit)) & 1u;
+}
+
+constexpr uint read_word(const uchar *data) {
+    return ((uint)data[0] << 24) | ((uint)data[1] << 16) | ((uint)data[2] << 8) | (uint)data[3];
+}
+
+/**
+ * A single instruction, decoded once and then passed around by value. Holds no pointers
+ * so vectors of these are a single contiguous allocation.
+ */
+struct DecodedInstruction {
+
+    enum Suffix : uchar { NONE = 0, LINK = 1, ABSOLUTE = 2, RECORD = 4 };
+
+    uint word;
+    uchar opcode;
+    ushort xo;
+    uchar rd, ra, rb, rc;
+    ushort imm;
+    Mnemonic mnemonic;
+    uchar suffix;
+
+    static constexpr ushort NO_XO = 0xFFFF;
+
+    bool is(Mnemonic other, uchar other_suffix = NONE) const {
+        return mnemonic == other && suffix == other_suffix;
+    }
+
+    short simm() const {
+        return (short)imm;
+    }
+
+    // Byte displacement of an I-form branch (b, bl, ba, bla), sign extended
+    int branch_offset() const {
+        return ((int)(word << 6) >> 6) & ~3;
+    }
+
+    void get_bytes(uchar *out) const {
+        out[0] = (uchar)(word >> 24);
+        out[1] = (uchar)(word >> 16);
+        out[2] = (uchar)(word >> 8);
+        out[3] = (uchar)word;
+    }
+
+};
+
+/**
+ * A read-only run of decoded instructions, owned by someone else. Like ByteSpan, but for a
+ * CodeSection's instructions.
+ */
+struct InstructionSpan {
+
+    const DecodedInstruction *data;
+    std::size_t length;
+
+    InstructionSpan() : data(nullptr), length(0) {}
+    InstructionSpan(const DecodedInstruction *data, std::size_t length) : data(data), length(length) {}
+    InstructionSpan(const std::vector<DecodedInstruction>& data) : data(data.data()), length(data.size()) {}
+
+    const DecodedInstruction *begin() const {
+        return data;
+    }
+
+    const DecodedInstruction *end() const {
+        return data + length;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    const DecodedInstruction& operator[](std::size_t index) const {
+        return data[index];
+    }
+
+    // Clamped to this span, like ByteSpan::subspan
+    InstructionSpan subspan(std::size_t offset, std::size_t count) const {
+        if (offset > length) {
+            offset = length;
+        }
+        return InstructionSpan(data + offset, count < length - offset ? count : length - offset);
+    }
+
+};
+
+// The key into the secondary tables for this opcode, or NO_XO if it has none
+ushort extended_opcode(uchar opcode, uint word);
+// Fill in mnemonic and suffix from the already extracted fields
+void resolve_mnemonic(DecodedInstruction& inst);
+DecodedInstruction decode(uint word);
+DecodedInstruction decode(const uchar *instruction);
+
+bool has_destination(const DecodedInstruction& inst);
+// RegisterRole flags saying which fields the instruction reads and writes
+uint register_roles(const DecodedInstruction& inst);
+
+// Longest mnemonic plus every suffix
+constexpr std::size_t MAX_CODE_NAME = 32;
+
+std::size_t format_code_name(const DecodedInstruction& inst, char *out);
+std::string code_name(const DecodedInstruction& inst);
+std::string_view operand_pattern(const DecodedInstruction& inst);
+std::string code_pattern(const DecodedInstruction& inst);
+std::string get_variables(const DecodedInstruction& inst);
+
+}
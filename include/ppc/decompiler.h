@@ -1,11 +1,42 @@
 #pragma once
 
 #include "types.h"
+#include "mapped_file.h"
+#include "ppc/code_section.h"
+#include "ppc/call_graph.h"
+#include "ppc/symbol_map.h"
 
 #include <string>
+#include <vector>
 
 namespace PPC {
 
+// Each function is lifted to SSA and written out a statement per value. Function inputs and outputs are
+// summarized bottom up over the section's call graph on up to jobs threads, 0 for one per hardware thread
+void decompile(CodeSection& section, const std::string& file_out, uint jobs = 1);
+// Decompile a run of code, base is the file offset of the first byte
+void decompile(ByteSpan code, const std::string& file_out, ulong base = 0, uint jobs = 1);
+
+/**
+ * A run of code to decompile as one part of a batch, into its own file
+ */
+struct DecompileUnit {
+    ByteSpan code;
+    // File offset of the first byte
+    ulong base;
+    std::string file_out;
+    // Address the code is loaded at, 0 if it's relocated. Calls between units are followed by it
+    ulong address = 0;
+    // Names for its functions, looked up by address, if any
+    const SymbolMap *names = nullptr;
+};
+
+// Decompile many runs of code together on up to jobs threads, 0 for one per hardware thread. All units
+// share one call graph, its summaries kept in cache if given. Every function is its own task, stolen by
+// whichever worker is free, and each file is written once its last function is done. Calls between units
+// with an address are followed, so their callers see what the callee does. Relocated units only follow
+// their own calls, and come out the same as decompiling them alone
+void decompile(const std::vector<DecompileUnit>& units, uint jobs = 0, SummaryCache *cache = nullptr);
 void decompile(const std::string& file_in, const std::string& file_out, int start, int end);
 
 }
@@ -1,9 +1,28 @@
 #pragma once
 
+#include <ostream>
 #include <string>
+#include "types.h"
+#include "mapped_file.h"
+#include "ppc/code_section.h"
 
 namespace PPC {
 
-void disassemble(const std::string& input, const std::string& output, int start = 0, int end = -1, bool info = true);
+/**
+ * Disassemble a run of code, base is the file offset of the first byte. With more than one job,
+ * functions are formatted in parallel, jobs = 0 uses one per hardware thread. The output is the
+ * same for any number of jobs. b and bl to the start of a function are printed with its name.
+ */
+void disassemble(CodeSection& section, const std::string& output, bool info = true, uint jobs = 1);
+void disassemble(ByteSpan code, const std::string& output, ulong base = 0, bool info = true, uint jobs = 1);
+void disassemble(const std::string& input, const std::string& output, int start = 0, int end = -1, bool info = true,
+                 uint jobs = 1);
+
+/**
+ * Write the listing of a run of code to output one function at a time, each as soon as it ends.
+ * Memory stays bounded by the largest function, plus a bit per word for the call targets, rather
+ * than the whole section. Branch targets stay as offsets, since later functions aren't named yet.
+ */
+void disassemble_stream(ByteSpan code, std::ostream& output, ulong base = 0, bool info = true);
 
 }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "types.h"
+#include "mapped_file.h"
+#include "ppc/code_section.h"
+
+namespace PPC {
+
+/*
+ * Index file layout, all in host byte order and 4 byte aligned so it can be used straight from a
+ * mapping: the header, then function_count IndexFunctions sorted by start, then instruction_count
+ * IndexInstructions, one per word of the section, then the name and operand text pools.
+ */
+
+struct IndexHeader {
+    char magic[4];
+    uint version;
+    uint base;
+    uint function_count;
+    uint instruction_count;
+    uint names_size;
+    uint text_size;
+    uint reserved;
+};
+
+struct IndexFunction {
+    // File offsets, end is one past the last instruction
+    uint start, end;
+    // Offset and length of the name in the name pool
+    uint name, name_length;
+};
+
+struct IndexInstruction {
+    uint word;
+    // Offset of the operand text in the text pool
+    uint operands;
+    ushort mnemonic;
+    uchar suffix;
+    uchar operand_length;
+};
+
+static_assert(sizeof(IndexHeader) == 32, "Index header must stay packed");
+static_assert(sizeof(IndexFunction) == 16, "Index functions must stay packed");
+static_assert(sizeof(IndexInstruction) == 12, "Index instructions must stay packed");
+
+constexpr uint INDEX_VERSION = 1;
+
+// Write the index of a section's functions and instructions to output
+void write_index(CodeSection& section, const std::string& output);
+
+/**
+ * A mapped index file. Finds the function holding an address by binary search over the starts,
+ * and the instruction directly, without touching the rest of the file.
+ */
+class SectionIndex {
+    
+    MappedFile file;
+    const IndexHeader *header;
+    const IndexFunction *functions;
+    const IndexInstruction *instructions;
+    const char *names;
+    const char *text;
+
+public:
+    
+    explicit SectionIndex(const std::string& filename);
+    
+    // False if the file couldn't be read or isn't an index this version understands
+    bool is_valid() const;
+    ulong get_base() const;
+    ulong function_count() const;
+    ulong instruction_count() const;
+    
+    // Function or instruction at a file offset, nullptr if there isn't one
+    const IndexFunction *find_function(ulong address) const;
+    const IndexInstruction *find_instruction(ulong address) const;
+    
+    std::string_view name(const IndexFunction& function) const;
+    std::string code_name(const IndexInstruction& instruction) const;
+    std::string_view operands(const IndexInstruction& instruction) const;
+    
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "types.h"
+#include "ppc/decoder.h"
+#include "ppc/symbol.h"
+#include "ppc/symbol_index.h"
+
+namespace PPC {
+
+/**
+ * Formats disassembly listings straight into a reusable byte buffer, with table driven hex and
+ * no temporary strings. Bound to a stream it writes out in BLOCK_SIZE blocks, otherwise it
+ * collects everything until cleared.
+ */
+class ListingWriter {
+
+    std::ostream *output;
+    std::vector<char> buffer;
+    std::size_t used;
+    // Width of the address column, including the 0x
+    uint address_width;
+    const SymbolIndex *names;
+
+    char *reserve(std::size_t length);
+    // Operand text for inst at a file offset, the target's name for a branch to a known symbol
+    std::string_view operands(const DecodedInstruction& inst, ulong address) const;
+    void write_line(const DecodedInstruction& inst, ulong position, bool info, std::string_view operands);
+
+public:
+
+    static constexpr std::size_t BLOCK_SIZE = 1u << 16;
+
+    ListingWriter();
+    explicit ListingWriter(std::ostream& output);
+    ListingWriter(const ListingWriter&) = delete;
+    ListingWriter& operator=(const ListingWriter&) = delete;
+    ~ListingWriter();
+
+    // Pad addresses so offsets up to size line up
+    void set_address_width(ulong size);
+    // Name b and bl targets from names in write_symbol, nullptr to leave them as offsets
+    void set_names(const SymbolIndex *names);
+
+    void write_symbol(const Symbol& symbol, ulong base, bool info);
+    void write_header(const Symbol& symbol);
+    void write_instruction(const DecodedInstruction& inst, ulong position, bool info);
+    void write(std::string_view text);
+
+    std::string_view contents() const;
+    void clear();
+    void flush();
+
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "ppc/decoder.h"
+#include "ppc/cfg.h"
+
+namespace PPC {
+
+// Registers a call may change, as the EABI gives them. r0, r3-r12 and f0-f13
+constexpr uint VOLATILE_GPRS = 0x00001FF9u;
+constexpr uint VOLATILE_FPRS = 0x00003FFFu;
+// Registers arguments are passed in, r3-r10 and f1-f8
+constexpr uint ARGUMENT_GPRS = 0x000007F8u;
+constexpr uint ARGUMENT_FPRS = 0x000001FEu;
+// Registers a value can come back in. r3-r4 and f1
+constexpr uint RETURN_GPRS = 0x00000018u;
+constexpr uint RETURN_FPRS = 0x00000002u;
+
+/**
+ * Registers a function takes and gives back, one bit per register number
+ */
+struct FunctionRegisters {
+    // Argument registers read before they're written
+    uint gpr_in, fpr_in;
+    uint gpr_out, fpr_out;
+    // Volatile registers it may change, by its own writes or its callees'
+    uint gpr_clobber, fpr_clobber;
+};
+
+// What a call is taken to do when nothing is known about its target
+constexpr FunctionRegisters UNKNOWN_CALL {0, 0, 0, 0, VOLATILE_GPRS, VOLATILE_FPRS};
+
+/**
+ * Works out which registers a function reads before writing and which it leaves a value in. Live
+ * registers flow backwards through the function's blocks until nothing changes, so reads on one
+ * path aren't hidden by writes on another. A call takes its target's registers from a summary if
+ * one is given, and is otherwise taken to read nothing and to overwrite the volatile registers.
+ * Only argument registers count as inputs. The stack pointer, the small data bases and the saved
+ * registers a prologue stores are live at entry too, but aren't passed by the caller.
+ * Keeps its buffers between functions, so one analyzer run over a whole section allocates next to
+ * nothing.
+ */
+class LivenessAnalyzer {
+
+    struct BlockState {
+        // Registers read before the block writes them, and everything it writes
+        uint gpr_use, gpr_def, fpr_use, fpr_def;
+        // Writes still standing at the end of the block, and everything the block or its calls may change
+        uint gpr_gen, fpr_gen;
+        uint gpr_kill, fpr_kill;
+        uint gpr_live, fpr_live;
+        uint gpr_reach, fpr_reach;
+    };
+
+    ControlFlowGraph graph;
+    std::vector<BlockState> states;
+    uint gpr_entry = 0, fpr_entry = 0;
+
+    void summarize(InstructionSpan instructions, uint block, const FunctionRegisters *calls, std::size_t& next_call);
+
+public:
+
+    // calls, if given, holds what the target of each call instruction does, in instruction order
+    FunctionRegisters analyze(InstructionSpan instructions, const FunctionRegisters *calls = nullptr);
+    // Everything live at entry to the last function analyzed, arguments or not
+    uint entry_gprs() const;
+    uint entry_fprs() const;
+
+};
+
+// Analyze a single function with a fresh analyzer
+FunctionRegisters analyze_liveness(InstructionSpan instructions);
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string_view>
+#include "types.h"
+
+namespace PPC {
+
+/**
+ * Stable ID for every mnemonic the decoder can produce. Suffixes for link, absolute and record forms
+ * are kept as flags on the decoded instruction, and names are only looked up when printing.
+ */
+enum class Mnemonic : ushort {
+    NONE,
+    // Names from the opcode tables
+    TWI, UNKNOWN_PAIRED_SINGLE, MULLI, SUBFIC, CMPLI, CMPI, ADDIC, ADDIC_DOT, ADDI, ADDIS, BC, SC, B,
+    UNKNOWN_SPEC_BRANCH, RLWIMI, RLWINM, RLWNM, ORI, ORIS, XORI, XORIS, ANDI_DOT, ANDIS_DOT, UNKNOWN_MATH, LWZ, LWZU,
+    LBZ, LBZU, STW, STWU, STB, STBU, LHZ, LHZU, LHA, LHAU, STH, STHU, LMW, SMTW, LFS, LFSU, LFD, LFDU, STFS, STFSU,
+    STFD, STFDU, PS_L, PS_LU, UNKNOWN_FLOATING_SINGLE, PS_ST, PS_STU, UNKNOWN_FLOATING_DOUBLE, PS_CMP, PS_LX, PS_STX,
+    UNKNOWN_ABS_NEGATE, PS_SUM0, PS_SUM1, PS_MULS0, PS_MULS1, PS_MADDS0, PS_MADDS1, PS_MERGE, PS_DIV, PS_SUB, PS_ADD,
+    PS_SEL, PS_RES, PS_MUL, PS_RSQRTE, PS_MSUB, PS_MADD, PS_NMSUB, PS_NMADD, PS_NEG, PS_MR, PS_NABS, PS_ABS, DCBZ_L,
+    MCRF, BCLR, CRNOR, RFI, CRANDC, ISYNC, CRXOR, CRNAND, CRAND, CREQV, CRORC, CROR, BCCTR, CMP, TW, SUBFC, ADDC,
+    MULHWU, MFCR, LWARX, LWZX, SLW, CNTLZW, AND, CMPL, SUBF, DCBST, LWZUX, ANDC, MULHW, MFMSR, DCBF, LBZX, NEG, LBZUX,
+    NOR, SUBFE, ADDE, MTCRF, MTMSR, STWCX, STWX, STWUX, SUBFZE, ADDZE, MTSR, STBX, SUBFME, ADDME, MULLW, MTSRIN,
+    DCBTST, STBUX, ADD, DCBT, LHZX, EQV, TLBIE, ECIWX, LHZUX, XOR, MFSPR, LHAX, TLBIA, MFTB, LHAUX, STHX, ORC, ECOWX,
+    STHUX, OR, DIVWU, MTSPR, DCBI, NAND, DIVW, MCRXR, SUBFCO, ADDCO, LSWX, LWBRX, LFSX, SRW, SUBFO, TLBSYNC, LFSUX,
+    MFSR, LSWI, SYNC, LFDX, NEGO, LFDUX, SUBFEO, ADDEO, STSWX, STWBRX, STFSX, STFSUX, SUBFZEO, ADDZEO, STSWI, STFDX,
+    SUBFMEO, ADDMEO, MULLWO, DCBA, STFDUX, ADDO, LHBRX, SRAW, SRAWI, EIEIO, STHBRX, EXTSH, EXTSB, DIVWUO, ICBI, STFIWX,
+    DIVWO, DCBZ, FDIVS, FSUBS, FADDS, FSQRTS, FRES, FMULS, FMSUBS, FMADDS, FNMSUBS, FNMADDS, FCMPU, FRSP, FCTIW,
+    FCTIWZ, FDIV, FSUB, FADD, FSQRT, FSEL, FMUL, FRSQRTE, FMSUB, FMADD, FNMSUB, FNMADD, FCMPO, MTFSB1, FNEG, MCRFS,
+    MTFSB0, FMR, MTFSFI, FNABS, FABS, MFFS, MTFSF,
+    // Forms special cased by the decoder
+    PADDING, UNKNOWN_INSTRUCTION, NOP, CMPWI, CMPLWI, CMPW, CMPLW, SUBIC, SUBIS, BLT, BNE, BLR, BLTLR, BDNZLR, BCTR,
+    BLTCTR, BDNZCTR, NOT, MR, MTCR, MFXER, MFLR, MFCTR, MTXER, MTLR, MTCTR, MFTBU, PS_CMPU0, PS_CMPO0, PS_CMPU1,
+    PS_CMPO1, PS_LUX, PS_STUX, PS_MERGE00, PS_MERGE01, PS_MERGE10, PS_MERGE11,
+    COUNT
+};
+
+inline constexpr std::string_view mnemonic_names[(ushort)Mnemonic::COUNT] = {
+    "",
+    "twi", "UNKNOWN PAIRED-SINGLE", "mulli", "subfic", "cmpli", "cmpi", "addic", "addic.", "addi", "addis", "bc", "sc",
+    "b", "UNKNOWN SPEC BRANCH", "rlwimi", "rlwinm", "rlwnm", "ori", "oris", "xori", "xoris", "andi.", "andis.",
+    "UNKNOWN MATH", "lwz", "lwzu", "lbz", "lbzu", "stw", "stwu", "stb", "stbu", "lhz", "lhzu", "lha", "lhau", "sth",
+    "sthu", "lmw", "smtw", "lfs", "lfsu", "lfd", "lfdu", "stfs", "stfsu", "stfd", "stfdu", "ps_l", "ps_lu",
+    "UNKNOWN FLOATING SINGLE", "ps_st", "ps_stu", "UNKNOWN FLOATING DOUBLE", "ps_cmp", "ps_lx", "ps_stx",
+    "UNKNOWN ABS/NEGATE", "ps_sum0", "ps_sum1", "ps_muls0", "ps_muls1", "ps_madds0", "ps_madds1", "ps_merge", "ps_div",
+    "ps_sub", "ps_add", "ps_sel", "ps_res", "ps_mul", "ps_rsqrte", "ps_msub", "ps_madd", "ps_nmsub", "ps_nmadd",
+    "ps_neg", "ps_mr", "ps_nabs", "ps_abs", "dcbz_l", "mcrf", "bclr", "crnor", "rfi", "crandc", "isync", "crxor",
+    "crnand", "crand", "creqv", "crorc", "cror", "bcctr", "cmp", "tw", "subfc", "addc", "mulhwu", "mfcr", "lwarx",
+    "lwzx", "slw", "cntlzw", "and", "cmpl", "subf", "dcbst", "lwzux", "andc", "mulhw", "mfmsr", "dcbf", "lbzx", "neg",
+    "lbzux", "nor", "subfe", "adde", "mtcrf", "mtmsr", "stwcx", "stwx", "stwux", "subfze", "addze", "mtsr", "stbx",
+    "subfme", "addme", "mullw", "mtsrin", "dcbtst", "stbux", "add", "dcbt", "lhzx", "eqv", "tlbie", "eciwx", "lhzux",
+    "xor", "mfspr", "lhax", "tlbia", "mftb", "lhaux", "sthx", "orc", "ecowx", "sthux", "or", "divwu", "mtspr", "dcbi",
+    "nand", "divw", "mcrxr", "subfco", "addco", "lswx", "lwbrx", "lfsx", "srw", "subfo", "tlbsync", "lfsux", "mfsr",
+    "lswi", "sync", "lfdx", "nego", "lfdux", "subfeo", "addeo", "stswx", "stwbrx", "stfsx", "stfsux", "subfzeo",
+    "addzeo", "stswi", "stfdx", "subfmeo", "addmeo", "mullwo", "dcba", "stfdux", "addo", "lhbrx", "sraw", "srawi",
+    "eieio", "sthbrx", "extsh", "extsb", "divwuo", "icbi", "stfiwx", "divwo", "dcbz", "fdivs", "fsubs", "fadds",
+    "fsqrts", "fres", "fmuls", "fmsubs", "fmadds", "fnmsubs", "fnmadds", "fcmpu", "frsp", "fctiw", "fctiwz", "fdiv",
+    "fsub", "fadd", "fsqrt", "fsel", "fmul", "frsqrte", "fmsub", "fmadd", "fnmsub", "fnmadd", "fcmpo", "mtfsb1",
+    "fneg", "mcrfs", "mtfsb0", "fmr", "mtfsfi", "fnabs", "fabs", "mffs", "mtfsf",
+    "PADDING", "UNKNOWN INSTRUCTION", "nop", "cmpwi", "cmplwi", "cmpw", "cmplw", "subic", "subis", "blt", "bne", "blr",
+    "bltlr", "bdnzlr", "bctr", "bltctr", "bdnzctr", "not", "mr", "mtcr", "mfxer", "mflr", "mfctr", "mtxer", "mtlr",
+    "mtctr", "mftbu", "ps_cmpu0", "ps_cmpo0", "ps_cmpu1", "ps_cmpo1", "ps_lux", "ps_stux", "ps_merge00", "ps_merge01",
+    "ps_merge10", "ps_merge11",
+};
+
+constexpr std::string_view mnemonic_name(Mnemonic mnemonic) {
+    return mnemonic_names[(ushort)mnemonic];
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string_view>
+#include "types.h"
+#include "ppc/decoder.h"
+
+namespace PPC {
+
+// Large enough for the longest operand pattern with every field at full width
+constexpr std::size_t MAX_OPERAND_TEXT = 96;
+
+struct OperandOp {
+
+    enum Kind : uchar { LITERAL, FIELD, SPR };
+    enum Flags : uchar { NONE = 0, SIGNED = 1, ABSOLUTE = 2, HEX = 4 };
+
+    Kind kind;
+    uchar flags;
+    // Bit range for fields, offset and length into the program text for literals
+    uchar start, end;
+
+};
+
+// A register operand of a pattern, and which bits hold its number
+struct RegisterOperand {
+
+    enum Kind : uchar { GPR, FPR, CR_FIELD, CR_BIT };
+
+    Kind kind;
+    uchar start, end;
+
+};
+
+/**
+ * An operand pattern compiled once into a flat list of ops, so formatting an instruction is a
+ * single pass over the ops with no parsing.
+ */
+struct OperandProgram {
+
+    static constexpr uint MAX_OPS = 16;
+    static constexpr uint MAX_TEXT = 32;
+    static constexpr uint MAX_REGISTERS = 5;
+
+    OperandOp ops[MAX_OPS];
+    uchar num_ops;
+    char text[MAX_TEXT];
+    uchar text_length;
+    // Register operands in pattern order, the first is the destination if the code has one
+    RegisterOperand registers[MAX_REGISTERS];
+    uchar num_registers;
+
+};
+
+OperandProgram compile_pattern(std::string_view pattern);
+const OperandProgram& get_program(std::string_view pattern);
+
+std::size_t format_operands(const OperandProgram& program, uint word, char *out);
+std::size_t format_operands(const DecodedInstruction& inst, char *out);
+
+}
@@ -28,4 +28,18 @@ public:
 
 Register::RType get_type(const std::string& type);
 
+/**
+ * Registers read and written by an instruction, one bit per register number.
+ * CR masks hold one bit per condition field.
+ */
+struct RegisterMasks {
+    uint gpr_read, gpr_write;
+    uint fpr_read, fpr_write;
+    uint cr_read, cr_write;
+};
+
+struct DecodedInstruction;
+
+RegisterMasks register_masks(const DecodedInstruction& inst);
+
 }
\ No newline at end of file
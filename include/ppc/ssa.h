@@ -0,0 +1,142 @@
+#pragma once
+
+#include "types.h"
+#include "arena.h"
+#include "ppc/decoder.h"
+#include "ppc/cfg.h"
+#include "ppc/liveness.h"
+
+namespace PPC {
+
+// Values are numbered from 0 in the order they were made
+using ValueId = uint;
+constexpr ValueId NO_VALUE = ~0u;
+
+// SSA variables, GPRs then FPRs then CR fields
+constexpr uint FPR_VARIABLE = 32;
+constexpr uint CR_VARIABLE = 64;
+constexpr uint NUM_VARIABLES = 72;
+
+/**
+ * What a value does. An instruction the lifter doesn't know becomes OPAQUE, reading the registers it
+ * reads and standing for the first one it writes, with RESULTs for the rest.
+ */
+enum class Op : uchar {
+    ARGUMENT, UNDEFINED, CONSTANT, PHI, RESULT,
+    ADD, SUB, MUL, DIV, AND, OR, XOR, SHIFT_LEFT, SHIFT_RIGHT, NEGATE,
+    LOAD, STORE, COMPARE, CALL, OPAQUE,
+    // Ends a block, one per reachable block
+    JUMP, BRANCH, RETURN, RETURN_IF
+};
+
+enum class ValueType : uchar { NONE, INT, FLOAT, CONDITION };
+
+/**
+ * One SSA value. Operands are other values by number, kept in a shared pool, so a function's IR
+ * holds no pointers and can be dropped in one go.
+ *
+ * Operands by op:
+ *   LOAD      base, offset, constant is 1 if it sign extends
+ *   STORE     value, base, offset, the type is the stored value's
+ *   COMPARE   two values, constant is 1 if unsigned. SHIFT_RIGHT likewise has 1 if arithmetic
+ *   CALL      r3-r10 then fr1-fr8 as they were at the call, the target address in constant, 0 if
+ *             it's through a register
+ *   BRANCH    the CR field tested, BO << 5 | BI in constant
+ *   RETURN    r3 and fr1 as they were at the return, RETURN_IF adds the CR field before them
+ *   RESULT    the value whose extra output it is, the register in variable
+ */
+struct Value {
+    Op op;
+    ValueType type;
+    // Bytes moved by a load or store
+    uchar width;
+    // Variable an argument, phi or result stands for
+    uchar variable;
+    uint block;
+    uint first_operand, num_operands;
+    int constant;
+    // Index in the function of the instruction it came from, NO_VALUE for phis and arguments
+    uint instruction;
+};
+
+/**
+ * Where a block's values are. Phis come first and have one operand per predecessor, in the order
+ * the graph lists them. Phis on the entry have one more, last, for the value it was called with.
+ */
+struct SSABlock {
+    uint first_phi, num_phis;
+    uint first_value, num_values;
+};
+
+/**
+ * A function lifted into SSA form. Phis go on the iterated dominance frontier of each variable's
+ * writes, then values are named by a walk down the dominator tree. Registers the function takes
+ * become ARGUMENTs, and reads of anything else never written become the one UNDEFINED value.
+ *
+ * Everything built for a function is kept in one arena, which is reset when the next is built, so
+ * the IR is thrown away in O(1) and one SSAFunction reused over a whole game stays the size of its
+ * largest function.
+ */
+class SSAFunction {
+
+    Arena arena;
+    ArenaVector<Value> values;
+    ArenaVector<ValueId> operand_pool;
+    ArenaVector<SSABlock> blocks;
+    ControlFlowGraph graph;
+    LivenessAnalyzer liveness;
+    FunctionRegisters registers;
+    InstructionSpan instructions;
+    ulong base;
+    ValueId current[NUM_VARIABLES];
+    ValueId undefined;
+
+    struct Saved {
+        uint variable;
+        ValueId value;
+    };
+    // Definitions replaced while renaming, put back on the way up the dominator tree
+    ArenaVector<Saved> saved;
+
+    ValueId use(uint variable) const;
+    void define(uint variable, ValueId value);
+    ValueId make(Op op, ValueType type, uint block, uint num_operands, uint instruction);
+    ValueId make_constant(int constant, uint block, uint instruction);
+    void set_operand(ValueId value, uint index, ValueId operand);
+    ValueId binary(Op op, ValueType type, ValueId first, ValueId second, uint block, uint instruction);
+
+    void place_phis();
+    void rename();
+    void lift_block(uint block);
+    void lift(uint block, uint index);
+    bool lift_known(uint block, uint index);
+    void lift_opaque(uint block, uint index);
+    void lift_call(uint block, uint index);
+    void lift_return(uint block, uint index, bool conditional);
+    void lift_end(uint block);
+
+public:
+
+    SSAFunction();
+
+    // Lift a function whose first instruction is at address base. Drops the last function's IR. calls,
+    // if given, is what the target of each call does, as LivenessAnalyzer takes it
+    void build(InstructionSpan instructions, ulong base = 0, const FunctionRegisters *calls = nullptr);
+
+    std::size_t size() const;
+    const Value& operator[](ValueId value) const;
+    EdgeSpan operands(ValueId value) const;
+
+    // One per block of the graph, unreachable blocks have no values
+    const SSABlock& block(uint block) const;
+    const ControlFlowGraph& get_graph() const;
+    // The function's inputs and outputs, from the same graph
+    const FunctionRegisters& get_registers() const;
+    ulong get_base() const;
+
+    // Bytes of IR for the current function
+    std::size_t memory_used() const;
+
+};
+
+}
@@ -1,37 +1,117 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 #include "types.h"
-#include "ppc/instruction.h"
+#include "arena.h"
+#include "mapped_file.h"
+#include "ppc/decoder.h"
 #include "ppc/register.h"
+#include "ppc/liveness.h"
 
 namespace PPC {
 
+/**
+ * A function found in a run of code. Symbols don't own their name or instructions, both live in
+ * whatever made the symbol, usually a CodeSection and its arena, so copying one is cheap.
+ */
 class Symbol {
     
     bool inputs_made;
-    std::set<Register> r_input, fr_input;
+    uint r_input, fr_input;
+    uint r_output, fr_output;
     
     void gen_inputs();
+    
+    friend void generate_inputs(Symbol& symbol);
+    friend void generate_inputs(std::vector<Symbol>& symbols, uint jobs);
 
 public:
 
 	ulong start, end;
-	std::string name;
-	std::vector<Instruction*> instructions;
+	std::string_view name;
+	// Every instruction from start to end, inclusive
+	InstructionSpan instructions;
 
-	Symbol(ulong start, ulong end, const std::string& name);
+	Symbol(ulong start, ulong end, std::string_view name);
 	
-	const std::set<Register>& get_input_regular();
-	const std::set<Register>& get_input_float();
+	// Input registers as masks, bit n set for rn/frn
+	uint get_input_regular();
+	uint get_input_float();
+	// Return registers as masks, only ever r3, r4 and fr1
+	uint get_output_regular();
+	uint get_output_float();
+	// Take inputs and outputs worked out elsewhere, such as from a call graph, instead of making them
+	void set_registers(const FunctionRegisters& registers);
+
+};
+
+/**
+ * One bit per instruction of a section, set where a function starts even though no return comes right
+ * before it: the target of any bl, or of a b from outside the return-delimited run it lands in. A second
+ * bit marks the returns that end a run, which is every one a bc from the same run doesn't jump past.
+ */
+class CallTargets {
+    
+    std::vector<std::uint64_t> bits, returns;
+    std::size_t count;
+
+public:
+    
+    CallTargets();
+    explicit CallTargets(std::size_t count);
+    
+    std::size_t size() const;
+    void mark(std::size_t index);
+    // False for anything past the end
+    bool contains(std::size_t index) const;
+    // Returns that end their function, rather than one a conditional branch from before jumps past
+    void mark_end(std::size_t index);
+    bool ends(std::size_t index) const;
+    
+};
+
+// Find every call target in a section in two linear sweeps. The ByteSpan form decodes as it goes and
+// keeps nothing but the bits, for callers that don't hold the decoded section
+CallTargets find_call_targets(InstructionSpan instructions);
+CallTargets find_call_targets(ByteSpan code);
+
+/**
+ * Splits a stream of instructions into symbols one instruction at a time, so callers can act on each
+ * symbol as soon as it ends without holding the rest of the section. A symbol ends at a return, or if
+ * targets are given at a return they say ends its function, and right before a call target.
+ */
+class SymbolSplitter {
+    
+    ulong base, sym_start, position;
+    bool skip_padding, ended;
+    const CallTargets *targets;
+    std::vector<DecodedInstruction> cur_instructions;
+    std::string cur_name;
 
+public:
+    
+    // base is the file offset of the first instruction pushed, targets has to outlive the splitter
+    explicit SymbolSplitter(ulong base = 0, const CallTargets *targets = nullptr);
+    
+    // Feed the next instruction. Returns true if it ended a symbol, which is then written to out. That
+    // symbol points into the splitter, and is only good until the next push
+    bool push(const DecodedInstruction& instruction, Symbol& out);
+    
 };
 
-std::vector<Symbol> generate_symbols(const std::string& file_in, int start = 0, int end = -1);
-void generate_inputs(std::vector<Symbol>& symbols);
-std::vector<Symbol> load_symbols(const std::string& file_in);
+// Symbols from a run of code, base is the file offset of the first instruction. The symbols point into
+// instructions, and their names are kept in arena
+std::vector<Symbol> generate_symbols(InstructionSpan instructions, Arena& arena, ulong base = 0);
+// Make the inputs of one symbol, if they aren't already. Different symbols can be done on different threads
+void generate_inputs(Symbol& symbol);
+// Make the inputs of every symbol on up to jobs threads, 0 for one per hardware thread. Each symbol is
+// analyzed once, after this its getters only read and can be called from any thread
+void generate_inputs(std::vector<Symbol>& symbols, uint jobs = 1);
+// Symbols from a file made by write_symbols or write_symbol_map, names are kept in arena
+std::vector<Symbol> load_symbols(const std::string& file_in, Arena& arena);
 void write_symbols(const std::vector<Symbol>& symbols, const std::string& file_out);
 
 }
\ No newline at end of file
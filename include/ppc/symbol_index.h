@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "types.h"
+#include "ppc/symbol.h"
+
+namespace PPC {
+
+/**
+ * Finds the symbol at or around an address in O(log n). Starts are kept in Eytzinger order, a
+ * binary tree laid out breadth first in one array, so a search walks down through neighbouring
+ * cache lines instead of jumping across a sorted array. Names are views into the symbols' storage,
+ * the index is only good as long as that is.
+ */
+class SymbolIndex {
+
+public:
+
+    struct Entry {
+        // File offsets, end is the last instruction like Symbol
+        ulong start, end;
+        std::string_view name;
+        // Position in the vector the index was built from
+        std::size_t id;
+    };
+
+private:
+
+    // Slot 0 is unused, slot k has children 2k and 2k + 1
+    std::vector<ulong> tree;
+    // Position in sorted of the start in each slot
+    std::vector<uint> ranks;
+    std::vector<Entry> sorted;
+
+    std::size_t build(std::size_t slot, std::size_t rank);
+    // Rank of the first start at or after address, size() if there isn't one
+    std::size_t lower_rank(ulong address) const;
+
+public:
+
+    SymbolIndex();
+    explicit SymbolIndex(const std::vector<Symbol>& symbols);
+
+    std::size_t size() const;
+
+    // Symbol whose range holds address, nullptr if none does
+    const Entry *find(ulong address) const;
+    // Symbol starting exactly at address, nullptr if none does
+    const Entry *at(ulong address) const;
+    // Symbols overlapping [first, last), in address order
+    std::pair<const Entry*, const Entry*> range(ulong first, ulong last) const;
+
+};
+
+}
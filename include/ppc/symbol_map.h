@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types.h"
+#include "arena.h"
+#include "mapped_file.h"
+#include "ppc/symbol.h"
+
+namespace PPC {
+
+/*
+ * Symbol map file layout, in host byte order and 4 byte aligned so it can be used straight from a
+ * mapping: the header, then count SymbolMapRecords sorted by start, then the name pool.
+ */
+
+struct SymbolMapHeader {
+    char magic[4];
+    uint version;
+    uint count;
+    uint names_size;
+};
+
+struct SymbolMapRecord {
+    // Addresses, end is the last instruction like Symbol
+    uint start, end;
+    // Offset and length of the name in the name pool
+    uint name, name_length;
+};
+
+static_assert(sizeof(SymbolMapHeader) == 16, "Symbol map header must stay packed");
+static_assert(sizeof(SymbolMapRecord) == 16, "Symbol map records must stay packed");
+
+constexpr uint SYMBOL_MAP_VERSION = 1;
+
+void write_symbol_map(const std::vector<Symbol>& symbols, const std::string& output);
+
+/**
+ * A mapped symbol map file. Nothing is parsed on load, records and names are read in place.
+ */
+class SymbolMap {
+    
+    MappedFile file;
+    const SymbolMapHeader *header;
+    const SymbolMapRecord *records;
+    const char *names;
+
+public:
+    
+    explicit SymbolMap(const std::string& filename);
+    
+    // False if the file couldn't be read or isn't a map this version understands
+    bool is_valid() const;
+    std::size_t size() const;
+    const SymbolMapRecord& operator[](std::size_t index) const;
+    std::string_view name(const SymbolMapRecord& record) const;
+    // The record starting at address, nullptr if there isn't one
+    const SymbolMapRecord *find(ulong address) const;
+    // The whole file as mapped
+    ByteSpan bytes() const;
+    
+    // A Symbol per record, named straight from the mapped file, so good as long as this map is
+    std::vector<Symbol> symbols() const;
+    
+};
+
+/**
+ * Read the symbols out of a CodeWarrior or Dolphin .map file. Lines in a section layout with a
+ * start, size, virtual address and name are kept, the section and object entries and anything
+ * unused are skipped. Symbols hold virtual addresses, with names copied into arena.
+ */
+std::vector<Symbol> import_map(ByteSpan text, Arena& arena);
+std::vector<Symbol> import_map(const std::string& filename, Arena& arena);
+
+}
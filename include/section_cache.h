@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "types.h"
+#include "mapped_file.h"
+
+// 64-bit xxHash of bytes
+std::uint64_t hash_bytes(ByteSpan bytes, std::uint64_t seed = 0);
+
+/**
+ * An on-disk store of per-section outputs, keyed by a hash of the section's bytes and the options
+ * that shaped the output. Lets a re-dump copy back the output of any section that hasn't changed
+ * instead of working it out again.
+ */
+class SectionCache {
+
+	std::string directory;
+
+	std::string path(const std::string& key) const;
+
+public:
+
+	// Bump when output changes for the same input, so old entries stop matching
+	static constexpr uint FORMAT_VERSION = 11;
+
+	explicit SectionCache(const std::string& directory);
+
+	// Key for the output made from code loaded at base, options names the kind of output and its flags
+	static std::string make_key(ByteSpan code, ulong base, const std::string& options);
+
+	// Copy the entry for key to filename, false if there isn't one
+	bool fetch(const std::string& key, const std::string& filename) const;
+	// Save a copy of filename as the entry for key
+	void store(const std::string& key, const std::string& filename) const;
+
+};
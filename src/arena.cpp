@@ -0,0 +1,96 @@
+
+#include <algorithm>
+#include <cstdint>
+
+#include "arena.h"
+
+static std::size_t align_up(std::size_t value, std::size_t align) {
+	return (value + align - 1) & ~(align - 1);
+}
+
+Arena::Arena(std::size_t block_size) {
+	this->used = 0;
+	this->handed_out = 0;
+	this->block_size = block_size;
+}
+
+Arena::Arena(Arena&& other) noexcept {
+	this->blocks = std::move(other.blocks);
+	this->used = other.used;
+	this->handed_out = other.handed_out;
+	this->block_size = other.block_size;
+	other.blocks.clear();
+	other.used = 0;
+	other.handed_out = 0;
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+	if (this != &other) {
+		this->blocks = std::move(other.blocks);
+		this->used = other.used;
+		this->handed_out = other.handed_out;
+		this->block_size = other.block_size;
+		other.blocks.clear();
+		other.used = 0;
+		other.handed_out = 0;
+	}
+	return *this;
+}
+
+void *Arena::grow(std::size_t size, std::size_t align) {
+	// Oversized requests get a block to themselves
+	Block block;
+	block.size = std::max(this->block_size, size + align);
+	block.data = std::make_unique<uchar[]>(block.size);
+	this->blocks.push_back(std::move(block));
+	this->used = 0;
+	return this->allocate(size, align);
+}
+
+void *Arena::allocate(std::size_t size, std::size_t align) {
+	if (!this->blocks.empty()) {
+		Block& last = this->blocks.back();
+		std::uintptr_t start = (std::uintptr_t)last.data.get();
+		std::size_t offset = align_up(start + this->used, align) - start;
+		if (offset + size <= last.size) {
+			this->used = offset + size;
+			this->handed_out += size;
+			return last.data.get() + offset;
+		}
+	}
+	return this->grow(size, align);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+	if (text.empty()) {
+		return std::string_view();
+	}
+	char *out = this->allocate_array<char>(text.length());
+	text.copy(out, text.length());
+	return std::string_view(out, text.length());
+}
+
+void Arena::reset() {
+	if (this->blocks.size() > 1) {
+		auto largest = std::max_element(this->blocks.begin(), this->blocks.end(), [](const Block& a, const Block& b) {
+			return a.size < b.size;
+		});
+		Block keep = std::move(*largest);
+		this->blocks.clear();
+		this->blocks.push_back(std::move(keep));
+	}
+	this->used = 0;
+	this->handed_out = 0;
+}
+
+std::size_t Arena::allocated() const {
+	return this->handed_out;
+}
+
+std::size_t Arena::capacity() const {
+	std::size_t out = 0;
+	for (const auto& block : this->blocks) {
+		out += block.size;
+	}
+	return out;
+}
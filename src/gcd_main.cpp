@@ -1,7 +1,10 @@
 
 #include <vector>
 #include <string>
+#include <charconv>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <experimental/filesystem>
 
 #include "at_logging"
@@ -11,6 +14,12 @@
 #include "ppc/ppc_reader.h"
 #include "ppc/disassembler.h"
 #include "ppc/decompiler.h"
+#include "ppc/decode_cache.h"
+#include "ppc/index.h"
+#include "ppc/symbol_map.h"
+#include "mapped_file.h"
+#include "section_cache.h"
+#include "parallel.h"
 #include "filetypes/lz.h"
 #include "filetypes/tpl.h"
 #include "filetypes/png.h"
@@ -22,7 +31,7 @@ logging::Logger *logger = logging::get_logger("main");
 
 static std::map<std::string, std::string> default_outs = {
     {"decomp", "root_decomp"}, {"dump", "root_dump"}, {"recompile", "recompile.rel"}, {"dol", "dol_dump"},
-    {"rel", "rel_dump"}, {"tpl", "tpl_out"}
+    {"rel", "rel_dump"}, {"tpl", "tpl_out"}, {"map", "symbols.sym"}
 };
 
 static std::map<std::string, command_handler> commands = {
@@ -31,22 +40,124 @@ static std::map<std::string, command_handler> commands = {
     {"recomp", &command_recomp},
     {"rel", &command_rel},
     {"dol", &command_dol},
+    {"query", &command_query},
+    {"map", &command_map},
     {"tpl", &command_tpl}
 };
 
-void process_rel(types::REL *rel, const std::vector<types::REL*>& knowns, const std::string& output, bool info) {
+// jobs is the thread count to use when --jobs isn't given or isn't a number
+static DumpOptions get_options(ArgParser& parser, uint jobs = 1) {
+    DumpOptions out;
+    out.info = !parser.has_flag("no-info");
+    out.jobs = jobs;
+    if (parser.has_variable("jobs")) {
+        const std::string value = parser.get_variable("jobs");
+        uint parsed;
+        const auto result = std::from_chars(value.data(), value.data() + value.size(), parsed);
+        if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+            logger->warn("Bad --jobs value " + value + ", using " + std::to_string(jobs));
+        } else if (parsed > hardware_jobs()) {
+            // More threads than cores only adds switching
+            logger->warn("--jobs=" + value + " is more than the " + std::to_string(hardware_jobs()) + " cores, using " +
+                         std::to_string(hardware_jobs()));
+            out.jobs = hardware_jobs();
+        } else {
+            out.jobs = parsed;
+        }
+    }
+    out.decomp = parser.has_flag("decomp");
+    out.index = parser.has_flag("index");
+    if (parser.has_variable("cache")) {
+        out.cache = std::make_unique<SectionCache>(parser.get_variable("cache"));
+    }
+    if (parser.has_variable("symbols")) {
+        out.names = std::make_unique<PPC::SymbolMap>(parser.get_variable("symbols"));
+        if (!out.names->is_valid()) {
+            logger->warn("Couldn't read symbol map " + parser.get_variable("symbols") + ", using generated names");
+            out.names.reset();
+        }
+    }
+    return out;
+}
+
+// Disassemble each executable section, and decompile or index it from the same decoded code if asked. Outputs
+// already in the cache are copied from there, and sections with nothing left to make are never decoded.
+// Functions are named from names by their load address, if it's given.
+static void process_code(const std::vector<Section>& sections, const MappedFile& file, const std::string& output,
+                         const DumpOptions& options, const PPC::SymbolMap *names) {
+    const SectionCache *cache = options.cache.get();
+    // The names show up in every output, so a different map is a different key
+    std::string named;
+    if (names != nullptr) {
+        named = " names " + std::to_string(hash_bytes(names->bytes()));
+    }
+    for (const auto& sect : sections) {
+        if (sect.exec && sect.offset) {
+            ByteSpan bytes = file.bytes().subspan(sect.offset, sect.length);
+            
+            std::stringstream name;
+            name << output << "/Section" << sect.id;
+            std::string ppc_name = name.str() + ".ppc", c_name = name.str() + ".c", idx_name = name.str() + ".idx";
+            
+            // Returns true if filename still has to be made
+            auto missing = [&](const std::string& filename, const std::string& options) {
+                return cache == nullptr || !cache->fetch(SectionCache::make_key(bytes, sect.offset, options), filename);
+            };
+            auto keep = [&](const std::string& filename, const std::string& options) {
+                if (cache != nullptr) {
+                    cache->store(SectionCache::make_key(bytes, sect.offset, options), filename);
+                }
+            };
+            
+            const std::string ppc_options = (options.info ? "ppc info" : "ppc") + named;
+            const std::string c_options = "c" + named, idx_options = "idx" + named;
+            bool need_ppc = missing(ppc_name, ppc_options);
+            bool need_c = options.decomp && missing(c_name, c_options);
+            bool need_idx = options.index && missing(idx_name, idx_options);
+            if (!need_ppc && !need_c && !need_idx) {
+                continue;
+            }
+            
+            PPC::CodeSection code(bytes, sect.offset);
+            if (names != nullptr) {
+                code.name_symbols(*names, sect.address);
+            }
+            if (need_ppc) {
+                PPC::disassemble(code, ppc_name, options.info, options.jobs);
+                keep(ppc_name, ppc_options);
+            }
+            if (need_idx) {
+                PPC::write_index(code, idx_name);
+                keep(idx_name, idx_options);
+            }
+            if (need_c) {
+                PPC::decompile(code, c_name, options.jobs);
+                keep(c_name, c_options);
+            }
+        }
+    }
+}
+
+// Print the disassembly of each executable section to stdout, a function at a time
+static void stream_code(const std::vector<Section>& sections, const MappedFile& file, bool info) {
+    for (const auto& sect : sections) {
+        if (sect.exec && sect.offset) {
+            std::cout << "; section: " << sect.id << "\n";
+            PPC::disassemble_stream(file.bytes().subspan(sect.offset, sect.length), std::cout, sect.offset, info);
+        }
+    }
+    std::cout.flush();
+}
+
+void process_rel(types::REL *rel, const std::vector<types::REL*>& knowns, const std::string& output,
+                 const DumpOptions& options) {
     fs::create_directory(fs::path(output));
     rel->dump_header(output + "/header.txt");
     rel->dump_sections(output + "/sections.txt");
     rel->dump_imports(output + "/imports.txt");
     
-    for (const auto& sect : rel->sections) {
-        if (sect.exec && sect.offset) {
-            std::stringstream name;
-            name << output << "/Section" << sect.id << ".ppc";
-            PPC::disassemble(rel->filename, name.str(), sect.offset, sect.offset + sect.length, info);
-        }
-    }
+    MappedFile file(rel->filename);
+    process_code(rel->sections, file, output, options, nullptr);
     
 	for (const auto& sect : rel->sections) {
 		if (!sect.exec && sect.offset != 0 && sect.length > 4 && rel->id == 1) {
@@ -57,21 +168,19 @@ void process_rel(types::REL *rel, const std::vector<types::REL*>& knowns, const
 	}
 }
 
-void process_dol(types::DOL *dol, const std::string& output, bool info) {
+void process_dol(types::DOL *dol, const std::string& output, const DumpOptions& options) {
     fs::create_directory(fs::path(output));
     dol->dump_all(output + "/dol.txt");
     
-    for (const auto& sect : dol->sections) {
-        if (sect.exec && sect.offset) {
-            std::stringstream name;
-            name << output << "/Section" << sect.id << ".ppc";
-            PPC::disassemble(dol->filename, name.str(), sect.offset, sect.offset + sect.length, info);
-        }
-    }
+    MappedFile file(dol->filename);
+    process_code(dol->sections, file, output, options, options.names.get());
 }
 
 int command_decomp(const std::string& input, const std::string& output, ArgParser& parser) {
     logger->info("Beginning root decompile. This will take a while.");
+    // The whole game is one batch of tasks, so keep every core on it unless told otherwise
+    DumpOptions options = get_options(parser, 0);
+    
     fs::create_directory(output);
     std::vector<types::REL*> knowns;
     types::DOL *main = nullptr;
@@ -91,16 +200,50 @@ int command_decomp(const std::string& input, const std::string& output, ArgParse
         logger->error("Couldn't find .dol file for game");
         return 1;
     }
-    // Process list of files.
-	for (auto sect = main->sections.begin(); sect != main->sections.end(); ++sect) {
-		if (sect->exec && sect->offset) {
-			std::stringstream name;
-			name << output << "/Section" << sect->id << ".c";
-			// TODO: do relocations on each REL
-			PPC::decompile(main->filename, name.str(), (sint)sect->offset, (sint)(sect->offset + sect->length));
-		}
-	}
+    // Every executable section of the DOL and the RELs goes into one batch, so the workers are never
+    // left waiting on the end of one section before starting the next. Only the DOL's sections have
+    // fixed addresses to find names at
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<PPC::DecompileUnit> units;
+    auto add_units = [&](const std::string& filename, const std::vector<Section>& sections, const std::string& dir,
+                         bool relocated) {
+        files.push_back(std::make_unique<MappedFile>(filename));
+        for (const auto& sect : sections) {
+            if (sect.exec && sect.offset) {
+                std::stringstream name;
+                name << dir << "/Section" << sect.id << ".c";
+                units.push_back(PPC::DecompileUnit {files.back()->bytes().subspan(sect.offset, sect.length), sect.offset,
+                                                    name.str(), relocated ? 0 : sect.address,
+                                                    relocated ? nullptr : options.names.get()});
+            }
+        }
+    };
+    
+    add_units(main->filename, main->sections, output, false);
+    for (auto rel : knowns) {
+        // TODO: do relocations on each REL
+        fs::path path(rel->filename.c_str());
+        std::string filename = path.filename().string();
+        std::string dir = output + "/" + filename.substr(0, filename.length() - 4);
+        fs::create_directory(dir);
+        add_units(rel->filename, rel->sections, dir, true);
+    }
     
+    // Summaries are kept next to the section cache, so a rerun only redoes what a patch touched
+    std::unique_ptr<PPC::SummaryCache> summaries;
+    if (options.cache) {
+        summaries = std::make_unique<PPC::SummaryCache>(parser.get_variable("cache") + "/summaries.bin");
+    }
+    PPC::decompile(units, options.jobs, summaries.get());
+    if (summaries) {
+        summaries->save();
+    }
+    
+    // Clean up memory
+    for (auto rel : knowns) {
+        delete rel;
+    }
+    delete main;
     logger->info("Root decompile complete");
 	return 0;
 }
@@ -122,7 +265,7 @@ int command_dump(const std::string& input, const std::string& output, ArgParser&
         }
     }
     
-    bool info = !parser.has_flag("no-info");
+    DumpOptions options = get_options(parser);
     
     // Process list of files. Disassemble, Form data lists, dump info.
     if (main == nullptr) {
@@ -130,12 +273,12 @@ int command_dump(const std::string& input, const std::string& output, ArgParser&
     } else {
         fs::path path(main->filename.c_str());
         std::string filename = path.filename().string();
-        process_dol(main, output + "/" + filename.substr(0, filename.length() - 4), info);
+        process_dol(main, output + "/" + filename.substr(0, filename.length() - 4), options);
     }
     for (auto rel : knowns) {
         fs::path path(rel->filename.c_str());
         std::string filename = path.filename().string();
-        process_rel(rel, knowns, output + "/" + filename.substr(0, filename.length() - 4), info);
+        process_rel(rel, knowns, output + "/" + filename.substr(0, filename.length() - 4), options);
     }
     
     // Clean up memory
@@ -156,15 +299,70 @@ int command_recomp(const std::string& input, const std::string& output, ArgParse
 int command_rel(const std::string& input, const std::string& output, ArgParser& parser) {
     types::REL rel(input);
     bool info = !parser.has_flag("no-info");
+    if (parser.has_flag("stream")) {
+        stream_code(rel.sections, MappedFile(rel.filename), info);
+        return 0;
+    }
     std::vector<types::REL*> temp = std::vector<types::REL*>();
-    process_rel(&rel, temp, output, info);
+    process_rel(&rel, temp, output, get_options(parser));
     return 0;
 }
 
 int command_dol(const std::string& input, const std::string& output, ArgParser& parser) {
     types::DOL dol(input);
     bool info = !parser.has_flag("no-info");
-    process_dol(&dol, output, info);
+    if (parser.has_flag("stream")) {
+        stream_code(dol.sections, MappedFile(dol.filename), info);
+        return 0;
+    }
+    process_dol(&dol, output, get_options(parser));
+    return 0;
+}
+
+int command_query(const std::string& input, const std::string& output, ArgParser&) {
+    PPC::SectionIndex index(input);
+    if (!index.is_valid()) {
+        logger->error("Couldn't read index " + input);
+        return 1;
+    }
+    
+    ulong address;
+    try {
+        address = std::stoul(output, nullptr, 0);
+    } catch (const std::logic_error&) {
+        logger->error("Expected an address, got " + output);
+        return 1;
+    }
+    
+    const PPC::IndexInstruction *inst = index.find_instruction(address);
+    if (inst == nullptr) {
+        logger->error("Address isn't in the indexed section");
+        return 1;
+    }
+    const PPC::IndexFunction *function = index.find_function(address);
+    
+    std::stringstream out;
+    out << std::hex << std::uppercase;
+    if (function != nullptr) {
+        out << "; function: " << index.name(*function) << " at 0x" << function->start << "\n";
+    } else {
+        out << "; function: none\n";
+    }
+    out << "0x" << address << "    " << index.code_name(*inst) << " " << index.operands(*inst) << "\n";
+    std::cout << out.str();
+    std::cout.flush();
+    return 0;
+}
+
+int command_map(const std::string& input, const std::string& output, ArgParser&) {
+    Arena arena;
+    std::vector<PPC::Symbol> symbols = PPC::import_map(input, arena);
+    if (symbols.empty()) {
+        logger->error("No symbols found in " + input);
+        return 1;
+    }
+    PPC::write_symbol_map(symbols, output);
+    logger->info("Wrote " + std::to_string(symbols.size()) + " symbols to " + output);
     return 0;
 }
 
@@ -215,7 +413,7 @@ int main(int argc, const char **argv) {
 
 	if (parser.num_arguments() == 0 && parser.has_flag("help")) {
 		std::cout << "Usage:\n";
-		std::cout << "  gcd (decomp|dump|rel|dol|tpl) [args]...\n";
+		std::cout << "  gcd (decomp|dump|rel|dol|query|map|tpl) [args]...\n";
 		std::cout << "Description:\n";
 		std::cout << "  The GameCube Decompiler is a tool designed to assist in working with GameCube hacking, especially ";
 		std::cout << "monkey ball. Still in alpha; send any inquiries, bug reports, or feature requests to CraftSpider.\n";
@@ -226,6 +424,13 @@ int main(int argc, const char **argv) {
 		std::cout << "  -vv: super verbose logging\n";
 		std::cout << "  -q: quiet logging\n";
 		std::cout << "  -qq: super quiet logging\n";
+		std::cout << "  --jobs=<n>: disassemble and analyze functions on n threads, 0 for one per core. decomp uses one per core by default, the rest one\n";
+		std::cout << "  --stream: with dol or rel, print the disassembly to stdout as it's made instead of dumping files\n";
+		std::cout << "  --decomp: also decompile each code section while dumping, sharing one decode\n";
+		std::cout << "  --index: also write a binary SectionN.idx per code section, for use with query\n";
+		std::cout << "  --cache=<dir>: keep section outputs in dir, and copy them back for sections that haven't changed. decomp also keeps function summaries there\n";
+		std::cout << "  --symbols=<file>: name the DOL's functions from a symbol map made by map\n";
+		std::cout << "  --decode-cache: cache decoded instruction words, and log how often it hit\n";
 		std::cout.flush();
 		return 0;
 	} else if (parser.num_arguments() == 0) {
@@ -250,6 +455,10 @@ int main(int argc, const char **argv) {
             usage << "  gcd rel [options] <file in> [directory out]\n";
         } else if (subcom == "dol") {
             usage << "  gcd dol [options] <file in> [directory out]\n";
+        } else if (subcom == "query") {
+            usage << "  gcd query [options] <index in> <address>\n";
+        } else if (subcom == "map") {
+            usage << "  gcd map [options] <.map in> [symbol map out]\n";
         } else if (subcom == "tpl") {
             usage << "  gcd tpl [options] (-e|-b|--extract|--build) <path in> [path out]\n";
         } else {
@@ -269,6 +478,9 @@ int main(int argc, const char **argv) {
         logging::set_default_level(logging::WARN);
     } else if (parser.flag_count("q") == 2) {
         logging::set_default_level(logging::ERROR);
+    } else if (parser.has_flag("stream")) {
+        // Keep stdout for the listing
+        logging::set_default_level(logging::ERROR);
     } else {
         logging::set_default_level(logging::INFO);
     }
@@ -293,7 +505,18 @@ int main(int argc, const char **argv) {
     std::string command_name = parser.get_argument(0);
     if (commands.count(command_name)) {
         command_handler command = commands[command_name];
-        return command(input, output, parser);
+        bool cache = parser.has_flag("decode-cache");
+        PPC::set_decode_cache(cache);
+        
+        int result = command(input, output, parser);
+        
+        if (cache) {
+            PPC::CacheStats stats = PPC::decode_cache_stats();
+            std::stringstream message;
+            message << "Decode cache: " << stats.hits << " hits, " << stats.misses << " misses";
+            logger->info(message.str());
+        }
+        return result;
     } else {
         std::cout << "Unrecognized Subcommand" << std::endl;
         return 1;
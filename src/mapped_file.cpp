@@ -0,0 +1,168 @@
+
+#include <fstream>
+#include <at_logging>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+static logging::Logger *logger = logging::get_logger("mapped_file");
+
+ByteSpan::ByteSpan() : ByteSpan(nullptr, 0) {}
+
+ByteSpan::ByteSpan(const uchar *data, std::size_t size) {
+	this->data = data;
+	this->size = size;
+}
+
+ByteSpan::ByteSpan(const std::vector<uchar>& data) : ByteSpan(data.data(), data.size()) {}
+
+const uchar *ByteSpan::begin() const {
+	return this->data;
+}
+
+const uchar *ByteSpan::end() const {
+	return this->data + this->size;
+}
+
+bool ByteSpan::empty() const {
+	return this->size == 0;
+}
+
+const uchar &ByteSpan::operator[](std::size_t index) const {
+	return this->data[index];
+}
+
+ByteSpan ByteSpan::subspan(std::size_t offset, std::size_t length) const {
+	if (offset >= this->size) {
+		return ByteSpan(this->end(), 0);
+	}
+	if (length > this->size - offset) {
+		length = this->size - offset;
+	}
+	return ByteSpan(this->data + offset, length);
+}
+
+MappedFile::MappedFile(const std::string& filename) {
+	this->mapping = nullptr;
+	this->opened = false;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (map != nullptr) {
+				this->mapping = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(map);
+			}
+			if (this->mapping != nullptr) {
+				this->view = ByteSpan((const uchar*)this->mapping, (std::size_t)size.QuadPart);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file != -1) {
+		struct stat info {};
+		if (fstat(file, &info) == 0 && info.st_size > 0) {
+			void *map = mmap(nullptr, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (map != MAP_FAILED) {
+				this->mapping = map;
+				this->view = ByteSpan((const uchar*)map, (std::size_t)info.st_size);
+			}
+		}
+		close(file);
+	}
+#endif
+
+	if (this->mapping != nullptr) {
+		this->opened = true;
+	} else {
+		this->read_fallback(filename);
+	}
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	this->mapping = nullptr;
+	this->opened = false;
+	*this = std::move(other);
+}
+
+MappedFile::~MappedFile() {
+	this->unmap();
+}
+
+MappedFile &MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		this->unmap();
+		this->mapping = other.mapping;
+		this->buffer = std::move(other.buffer);
+		this->opened = other.opened;
+		this->view = this->mapping != nullptr ? other.view : ByteSpan(this->buffer);
+
+		other.mapping = nullptr;
+		other.opened = false;
+		other.view = ByteSpan();
+	}
+	return *this;
+}
+
+void MappedFile::read_fallback(const std::string& filename) {
+	std::ifstream input(filename, std::ios::in | std::ios::binary);
+	if (!input.is_open()) {
+		logger->error("Couldn't open file " + filename);
+		return;
+	}
+
+	input.seekg(0, std::ios::end);
+	std::streamoff size = input.tellg();
+	input.seekg(0, std::ios::beg);
+	if (size > 0) {
+		this->buffer.resize((std::size_t)size);
+		input.read((char*)this->buffer.data(), size);
+		this->buffer.resize((std::size_t)input.gcount());
+	}
+
+	this->view = ByteSpan(this->buffer);
+	this->opened = true;
+}
+
+void MappedFile::unmap() {
+	if (this->mapping != nullptr) {
+#ifdef _WIN32
+		UnmapViewOfFile(this->mapping);
+#else
+		munmap(this->mapping, this->view.size);
+#endif
+		this->mapping = nullptr;
+	}
+}
+
+bool MappedFile::is_open() const {
+	return this->opened;
+}
+
+bool MappedFile::is_mapped() const {
+	return this->mapping != nullptr;
+}
+
+std::size_t MappedFile::size() const {
+	return this->view.size;
+}
+
+ByteSpan MappedFile::bytes() const {
+	return this->view;
+}
@@ -0,0 +1,184 @@
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+uint hardware_jobs() {
+	uint out = std::thread::hardware_concurrency();
+	return out ? out : 1;
+}
+
+void parallel_for(std::size_t count, uint jobs, const std::function<void(std::size_t)>& body) {
+	if (jobs == 0) {
+		jobs = hardware_jobs();
+	}
+	if (jobs > count) {
+		jobs = (uint)count;
+	}
+	if (jobs <= 1) {
+		for (std::size_t i = 0; i < count; ++i) {
+			body(i);
+		}
+		return;
+	}
+
+	std::atomic<std::size_t> next {0};
+	std::exception_ptr error;
+	std::mutex error_lock;
+
+	auto worker = [&]() {
+		std::size_t i;
+		while ((i = next.fetch_add(1)) < count) {
+			try {
+				body(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(error_lock);
+				if (!error) {
+					error = std::current_exception();
+				}
+				// Stop handing out work
+				next = count;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint i = 1; i < jobs; ++i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+// The scheduler and worker the current thread is running tasks for, if any
+static thread_local const TaskScheduler *current_scheduler = nullptr;
+static thread_local uint current_worker = 0;
+
+TaskScheduler::TaskScheduler(uint jobs) : pending(0), queued(0), next_worker(0) {
+	if (jobs == 0) {
+		jobs = hardware_jobs();
+	}
+	for (uint i = 0; i < jobs; ++i) {
+		this->workers.push_back(std::make_unique<Worker>());
+	}
+}
+
+uint TaskScheduler::size() const {
+	return (uint)this->workers.size();
+}
+
+void TaskScheduler::push(Task task) {
+	uint worker;
+	if (current_scheduler == this) {
+		worker = current_worker;
+	} else {
+		worker = this->next_worker;
+		this->next_worker = (this->next_worker + 1) % this->size();
+	}
+	
+	this->pending.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> guard(this->workers[worker]->lock);
+		this->workers[worker]->tasks.push_back(std::move(task));
+		this->queued.fetch_add(1);
+	}
+	// Taking the lock orders this after a sleeping worker's check, so the wakeup can't be missed
+	std::lock_guard<std::mutex> guard(this->idle_lock);
+	this->idle.notify_one();
+}
+
+bool TaskScheduler::take(uint worker, Task& out) {
+	{
+		Worker& own = *this->workers[worker];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.tasks.empty()) {
+			out = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			this->queued.fetch_sub(1);
+			return true;
+		}
+	}
+	// Steal from the front, the oldest tasks are the ones most likely to spawn more work
+	for (uint i = 1; i < this->size(); ++i) {
+		Worker& victim = *this->workers[(worker + i) % this->size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			out = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			this->queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::work(uint worker) {
+	current_scheduler = this;
+	current_worker = worker;
+	
+	Task task;
+	while (this->pending.load() != 0) {
+		if (!this->take(worker, task)) {
+			// Nothing to steal, the running tasks may still push more
+			std::unique_lock<std::mutex> guard(this->idle_lock);
+			this->idle.wait(guard, [this]() { return this->queued.load() != 0 || this->pending.load() == 0; });
+			continue;
+		}
+		bool failed;
+		{
+			std::lock_guard<std::mutex> guard(this->error_lock);
+			failed = (bool)this->error;
+		}
+		if (!failed) {
+			try {
+				task();
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(this->error_lock);
+				if (!this->error) {
+					this->error = std::current_exception();
+				}
+			}
+		}
+		task = nullptr;
+		// Only counted done after anything it pushed, so pending can't touch 0 while work is left
+		if (this->pending.fetch_sub(1) == 1) {
+			std::lock_guard<std::mutex> guard(this->idle_lock);
+			this->idle.notify_all();
+		}
+	}
+	
+	current_scheduler = nullptr;
+}
+
+void TaskScheduler::run() {
+	const TaskScheduler *outer_scheduler = current_scheduler;
+	const uint outer_worker = current_worker;
+	
+	std::vector<std::thread> threads;
+	for (uint i = 1; i < this->size(); ++i) {
+		threads.emplace_back([this, i]() { this->work(i); });
+	}
+	this->work(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	
+	current_scheduler = outer_scheduler;
+	current_worker = outer_worker;
+	
+	if (this->error) {
+		std::exception_ptr error = this->error;
+		this->error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
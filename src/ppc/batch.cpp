@@ -0,0 +1,160 @@
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ppc/batch.h"
+
+namespace PPC {
+
+std::size_t DecodedBlock::size() const {
+    return this->words.size();
+}
+
+void DecodedBlock::resize(std::size_t size) {
+    this->words.resize(size);
+    this->opcode.resize(size);
+    this->rd.resize(size);
+    this->ra.resize(size);
+    this->rb.resize(size);
+    this->rc.resize(size);
+    this->xo.resize(size);
+    this->imm.resize(size);
+}
+
+DecodedInstruction DecodedBlock::get(std::size_t index) const {
+    DecodedInstruction out {};
+    out.word = this->words[index];
+    out.opcode = this->opcode[index];
+    out.rd = this->rd[index];
+    out.ra = this->ra[index];
+    out.rb = this->rb[index];
+    out.rc = this->rc[index];
+    out.imm = this->imm[index];
+    out.xo = extended_opcode(out.opcode, out.word);
+    resolve_mnemonic(out);
+    return out;
+}
+
+static void decode_scalar(const uchar *data, std::size_t start, std::size_t end, DecodedBlock& out) {
+    for (std::size_t i = start; i < end; ++i) {
+        uint word = read_word(data + i * 4);
+        out.words[i] = word;
+        out.opcode[i] = (uchar)get_bits(word, 0, 5);
+        out.rd[i] = (uchar)get_bits(word, 6, 10);
+        out.ra[i] = (uchar)get_bits(word, 11, 15);
+        out.rb[i] = (uchar)get_bits(word, 16, 20);
+        out.rc[i] = (uchar)get_bits(word, 21, 25);
+        out.xo[i] = (ushort)get_bits(word, 21, 30);
+        out.imm[i] = (ushort)get_bits(word, 16, 31);
+    }
+}
+
+#if defined(__AVX2__)
+
+// 8 words per step. Packs are per 128 bit lane, so each narrowed field comes out as two halves.
+
+static void store_bytes(uchar *out, __m256i values) {
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(values, values), values);
+    uint low = (uint)_mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    uint high = (uint)_mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+    std::memcpy(out, &low, 4);
+    std::memcpy(out + 4, &high, 4);
+}
+
+static void store_shorts(ushort *out, __m256i values) {
+    // Bias into signed range so the saturating pack keeps all 16 bits
+    const __m256i bias = _mm256_set1_epi32(0x8000);
+    __m256i packed = _mm256_packs_epi32(_mm256_sub_epi32(values, bias), values);
+    packed = _mm256_xor_si256(packed, _mm256_set1_epi16((short)0x8000));
+    _mm_storel_epi64((__m128i*)out, _mm256_castsi256_si128(packed));
+    _mm_storel_epi64((__m128i*)(out + 4), _mm256_extracti128_si256(packed, 1));
+}
+
+static std::size_t decode_simd(const uchar *data, std::size_t count, DecodedBlock& out) {
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i five = _mm256_set1_epi32(0x1F);
+    const __m256i ten = _mm256_set1_epi32(0x3FF);
+    const __m256i sixteen = _mm256_set1_epi32(0xFFFF);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i words = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(data + i * 4)), swap);
+        _mm256_storeu_si256((__m256i*)&out.words[i], words);
+
+        store_bytes(&out.opcode[i], _mm256_srli_epi32(words, 26));
+        store_bytes(&out.rd[i], _mm256_and_si256(_mm256_srli_epi32(words, 21), five));
+        store_bytes(&out.ra[i], _mm256_and_si256(_mm256_srli_epi32(words, 16), five));
+        store_bytes(&out.rb[i], _mm256_and_si256(_mm256_srli_epi32(words, 11), five));
+        store_bytes(&out.rc[i], _mm256_and_si256(_mm256_srli_epi32(words, 6), five));
+        store_shorts(&out.xo[i], _mm256_and_si256(_mm256_srli_epi32(words, 1), ten));
+        store_shorts(&out.imm[i], _mm256_and_si256(words, sixteen));
+    }
+    return i;
+}
+
+#elif defined(__SSE2__)
+
+// 4 words per step, SSE2 has no byte shuffle so the swap is done with shifts.
+
+static void store_bytes(uchar *out, __m128i values) {
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(values, values), values);
+    uint low = (uint)_mm_cvtsi128_si32(packed);
+    std::memcpy(out, &low, 4);
+}
+
+static void store_shorts(ushort *out, __m128i values) {
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    __m128i packed = _mm_packs_epi32(_mm_sub_epi32(values, bias), values);
+    packed = _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+    _mm_storel_epi64((__m128i*)out, packed);
+}
+
+static std::size_t decode_simd(const uchar *data, std::size_t count, DecodedBlock& out) {
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    const __m128i five = _mm_set1_epi32(0x1F);
+    const __m128i ten = _mm_set1_epi32(0x3FF);
+    const __m128i sixteen = _mm_set1_epi32(0xFFFF);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i raw = _mm_loadu_si128((const __m128i*)(data + i * 4));
+        __m128i words = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(raw, 24), _mm_slli_epi32(_mm_and_si128(raw, _mm_slli_epi32(low_byte, 8)), 8)),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(raw, 8), _mm_slli_epi32(low_byte, 8)), _mm_srli_epi32(raw, 24))
+        );
+        _mm_storeu_si128((__m128i*)&out.words[i], words);
+
+        store_bytes(&out.opcode[i], _mm_srli_epi32(words, 26));
+        store_bytes(&out.rd[i], _mm_and_si128(_mm_srli_epi32(words, 21), five));
+        store_bytes(&out.ra[i], _mm_and_si128(_mm_srli_epi32(words, 16), five));
+        store_bytes(&out.rb[i], _mm_and_si128(_mm_srli_epi32(words, 11), five));
+        store_bytes(&out.rc[i], _mm_and_si128(_mm_srli_epi32(words, 6), five));
+        store_shorts(&out.xo[i], _mm_and_si128(_mm_srli_epi32(words, 1), ten));
+        store_shorts(&out.imm[i], _mm_and_si128(words, sixteen));
+    }
+    return i;
+}
+
+#else
+
+static std::size_t decode_simd(const uchar*, std::size_t, DecodedBlock&) {
+    return 0;
+}
+
+#endif
+
+void decode_range(const uchar *data, std::size_t size, DecodedBlock& out) {
+    const std::size_t count = size / 4;
+    out.resize(count);
+
+    std::size_t done = decode_simd(data, count, out);
+    decode_scalar(data, done, count, out);
+}
+
+}
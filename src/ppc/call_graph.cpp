@@ -0,0 +1,458 @@
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <at_logging>
+
+#include "ppc/call_graph.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "section_cache.h"
+
+namespace PPC {
+
+static logging::Logger *logger = logging::get_logger("ppc.calls");
+
+/*
+ * Summary cache file layout, in host byte order: the header, then count records in no particular order.
+ */
+
+struct SummaryCacheHeader {
+    char magic[4];
+    uint version;
+    std::uint64_t count;
+};
+
+struct SummaryCacheRecord {
+    std::uint64_t key;
+    FunctionRegisters registers;
+};
+
+static_assert(sizeof(SummaryCacheHeader) == 16, "Summary cache header must stay packed");
+static_assert(sizeof(SummaryCacheRecord) == 32, "Summary cache records must stay packed");
+
+static const char SUMMARY_CACHE_MAGIC[4] = {'G', 'C', 'D', 'F'};
+
+SummaryCache::SummaryCache(const std::string& filename) {
+    this->filename = filename;
+
+    MappedFile file(filename);
+    ByteSpan bytes = file.bytes();
+    if (!file.is_open() || bytes.size < sizeof(SummaryCacheHeader)) {
+        return;
+    }
+    SummaryCacheHeader header;
+    std::memcpy(&header, bytes.data, sizeof(header));
+    if (std::memcmp(header.magic, SUMMARY_CACHE_MAGIC, sizeof(SUMMARY_CACHE_MAGIC)) != 0 ||
+        header.version != FORMAT_VERSION) {
+        return;
+    }
+    if ((bytes.size - sizeof(header)) / sizeof(SummaryCacheRecord) < header.count) {
+        logger->warn("Summary cache " + filename + " is truncated");
+        return;
+    }
+
+    this->entries.reserve((std::size_t)header.count);
+    for (std::size_t i = 0; i < header.count; ++i) {
+        SummaryCacheRecord record;
+        std::memcpy(&record, bytes.data + sizeof(header) + i * sizeof(record), sizeof(record));
+        this->entries[record.key] = record.registers;
+    }
+}
+
+std::size_t SummaryCache::size() const {
+    return this->entries.size();
+}
+
+bool SummaryCache::find(std::uint64_t key, FunctionRegisters& out) const {
+    auto entry = this->entries.find(key);
+    if (entry == this->entries.end()) {
+        return false;
+    }
+    out = entry->second;
+    return true;
+}
+
+void SummaryCache::insert(std::uint64_t key, const FunctionRegisters& registers) {
+    this->entries[key] = registers;
+}
+
+void SummaryCache::clear() {
+    this->entries.clear();
+}
+
+void SummaryCache::save() const {
+    SummaryCacheHeader header {};
+    std::memcpy(header.magic, SUMMARY_CACHE_MAGIC, sizeof(SUMMARY_CACHE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = this->entries.size();
+
+    std::vector<SummaryCacheRecord> records;
+    records.reserve(this->entries.size());
+    for (const auto& entry : this->entries) {
+        records.push_back(SummaryCacheRecord {entry.first, entry.second});
+    }
+
+    // Write then rename, so a half written file is never picked up
+    const std::string temp = this->filename + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::out | std::ios::binary);
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)records.data(), (std::streamsize)(records.size() * sizeof(SummaryCacheRecord)));
+        if (!out) {
+            logger->warn("Couldn't write summary cache " + this->filename);
+            return;
+        }
+    }
+    if (std::rename(temp.c_str(), this->filename.c_str()) != 0) {
+        logger->warn("Couldn't replace summary cache " + this->filename);
+    }
+}
+
+// Grow into by every register in from, true if that added any
+static bool merge(FunctionRegisters& into, const FunctionRegisters& from) {
+    const FunctionRegisters before = into;
+    into.gpr_in |= from.gpr_in;
+    into.fpr_in |= from.fpr_in;
+    into.gpr_out |= from.gpr_out;
+    into.fpr_out |= from.fpr_out;
+    into.gpr_clobber |= from.gpr_clobber;
+    into.fpr_clobber |= from.fpr_clobber;
+    return std::memcmp(&before, &into, sizeof(FunctionRegisters)) != 0;
+}
+
+CallGraph::CallGraph(const std::vector<CodeSection*>& sections, const std::vector<ulong>& addresses) {
+    this->sections = sections;
+    this->addresses = addresses;
+    this->addresses.resize(sections.size(), 0);
+    for (uint s = 0; s < sections.size(); ++s) {
+        if (this->addresses[s] != 0) {
+            this->placed.push_back(s);
+        }
+    }
+    std::sort(this->placed.begin(), this->placed.end(), [this](uint a, uint b) {
+        return this->addresses[a] < this->addresses[b];
+    });
+    for (uint s = 0; s < sections.size(); ++s) {
+        this->first_function.push_back((uint)this->functions.size());
+        const std::size_t count = sections[s]->get_symbols().size();
+        for (std::size_t i = 0; i < count; ++i) {
+            this->functions.push_back(Function {s, (uint)i});
+        }
+    }
+    this->find_calls();
+    this->find_components();
+}
+
+void CallGraph::find_calls() {
+    this->call_offsets.assign(1, 0);
+    this->call_targets.clear();
+    for (const auto& function : this->functions) {
+        CodeSection& section = *this->sections[function.section];
+        const Symbol& symbol = section.get_symbols()[function.symbol];
+        const InstructionSpan instructions = symbol.instructions;
+        // Placed sections branch between virtual addresses, the rest between file offsets
+        const ulong address = this->addresses[function.section];
+        const ulong start = address != 0 ? address + (symbol.start - section.get_base()) : symbol.start;
+
+        for (std::size_t i = 0; i < instructions.size(); ++i) {
+            const DecodedInstruction& inst = instructions[i];
+            if (!branch_flow(inst, i, instructions.size()).calls) {
+                continue;
+            }
+            uint target = NONE;
+            if (inst.opcode != 19) {
+                target = this->function_at(function.section, (ulong)(uint)branch_address(inst, start + i * 4));
+            }
+            this->call_targets.push_back(target);
+        }
+        this->call_offsets.push_back((uint)this->call_targets.size());
+    }
+}
+
+uint CallGraph::function_at(uint section, ulong address) const {
+    if (this->addresses[section] != 0) {
+        // The placed section holding address is the last one starting at or before it
+        auto before = [this](ulong value, uint s) {
+            return value < this->addresses[s];
+        };
+        auto after = std::upper_bound(this->placed.begin(), this->placed.end(), address, before);
+        if (after == this->placed.begin()) {
+            return NONE;
+        }
+        section = *(after - 1);
+        const ulong offset = address - this->addresses[section];
+        if (offset >= this->sections[section]->bytes().size) {
+            return NONE;
+        }
+        address = this->sections[section]->get_base() + offset;
+    }
+    const SymbolIndex::Entry *entry = this->sections[section]->get_symbol_index().at(address);
+    return entry == nullptr ? NONE : this->first_function[section] + (uint)entry->id;
+}
+
+void CallGraph::find_components() {
+    // Tarjan's algorithm, with the path kept as pairs of a function and the next of its calls to follow.
+    // A component is finished only after everything it reaches, which is the bottom up order wanted
+    const uint count = (uint)this->size();
+    std::vector<uint> number(count, NONE), low(count, 0), stack, path;
+    std::vector<bool> on_stack(count, false);
+    uint next_number = 0;
+
+    this->component_offsets.assign(1, 0);
+    this->component_members.clear();
+    this->components.assign(count, NONE);
+
+    auto enter = [&](uint function) {
+        number[function] = low[function] = next_number++;
+        stack.push_back(function);
+        on_stack[function] = true;
+        path.push_back(function);
+        path.push_back(0);
+    };
+
+    for (uint root = 0; root < count; ++root) {
+        if (number[root] != NONE) {
+            continue;
+        }
+        enter(root);
+        while (!path.empty()) {
+            const uint function = path[path.size() - 2];
+            const EdgeSpan next = this->calls(function);
+            const uint edge = path.back();
+            if (edge < next.size()) {
+                path.back()++;
+                const uint target = next[edge];
+                if (target == NONE) {
+                    continue;
+                }
+                if (number[target] == NONE) {
+                    enter(target);
+                } else if (on_stack[target]) {
+                    low[function] = std::min(low[function], number[target]);
+                }
+                continue;
+            }
+
+            path.resize(path.size() - 2);
+            if (!path.empty()) {
+                const uint caller = path[path.size() - 2];
+                low[caller] = std::min(low[caller], low[function]);
+            }
+            if (low[function] == number[function]) {
+                const uint component = (uint)this->component_offsets.size() - 1;
+                uint member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    this->components[member] = component;
+                    this->component_members.push_back(member);
+                } while (member != function);
+                // Members in function order, so a component's key doesn't hang on the order of the walk
+                std::sort(this->component_members.begin() + this->component_offsets.back(),
+                          this->component_members.end());
+                this->component_offsets.push_back((uint)this->component_members.size());
+            }
+        }
+    }
+}
+
+ByteSpan CallGraph::code(uint function) const {
+    const CodeSection& section = *this->sections[this->functions[function].section];
+    const Symbol& symbol = this->symbol(function);
+    return section.bytes().subspan(symbol.start - section.get_base(), symbol.end - symbol.start + 4);
+}
+
+bool CallGraph::solve(uint component, const SummaryCache *cache) {
+    // Kept per thread, so components after the first allocate next to nothing
+    static thread_local LivenessAnalyzer analyzer;
+    static thread_local std::vector<FunctionRegisters> callees;
+    static thread_local std::vector<uint> seed_words;
+
+    const EdgeSpan members = this->members(component);
+
+    // The key covers the members' code and what every call out of the component does, so a callee
+    // whose summary comes out the same after a change leaves its callers' keys alone
+    seed_words.clear();
+    seed_words.push_back(SummaryCache::FORMAT_VERSION);
+    bool recursive = members.size() > 1;
+    for (uint function : members) {
+        seed_words.push_back(NONE);
+        for (uint target : this->calls(function)) {
+            if (target == NONE) {
+                seed_words.push_back(NONE);
+            } else if (this->components[target] == component) {
+                recursive = true;
+                seed_words.push_back((uint)(std::lower_bound(members.begin(), members.end(), target) - members.begin()));
+            } else {
+                const uint *words = (const uint*)&this->summaries[target];
+                seed_words.insert(seed_words.end(), words, words + sizeof(FunctionRegisters) / sizeof(uint));
+            }
+        }
+    }
+    std::uint64_t seed = hash_bytes(ByteSpan((const uchar*)seed_words.data(), seed_words.size() * sizeof(uint)));
+    for (uint function : members) {
+        seed = hash_bytes(this->code(function), seed);
+    }
+    for (std::size_t i = 0; i < members.size(); ++i) {
+        this->keys[members[i]] = hash_bytes(this->code(members[i]), seed + i);
+    }
+
+    if (cache != nullptr) {
+        bool found = true;
+        for (uint function : members) {
+            found = found && cache->find(this->keys[function], this->summaries[function]);
+        }
+        if (found) {
+            return true;
+        }
+        for (uint function : members) {
+            this->summaries[function] = FunctionRegisters {};
+        }
+    }
+
+    // Summaries only ever grow, so going round a cycle until nothing changes always ends
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint function : members) {
+            this->call_summaries(function, callees);
+            const FunctionRegisters registers = analyzer.analyze(this->symbol(function).instructions, callees.data());
+            changed |= merge(this->summaries[function], registers);
+        }
+        changed &= recursive;
+    }
+    return false;
+}
+
+SummaryStats CallGraph::summarize(uint jobs, SummaryCache *cache) {
+    const uint count = (uint)this->num_components();
+    this->summaries.assign(this->size(), FunctionRegisters {});
+    this->keys.assign(this->size(), 0);
+
+    // Each component waits on the components it calls into, and lets its callers know when it's done
+    std::vector<std::pair<uint, uint>> edges;
+    std::vector<uint> seen(count, NONE);
+    for (uint c = 0; c < count; ++c) {
+        for (uint function : this->members(c)) {
+            for (uint target : this->calls(function)) {
+                if (target == NONE || this->components[target] == c || seen[this->components[target]] == c) {
+                    continue;
+                }
+                seen[this->components[target]] = c;
+                edges.emplace_back(this->components[target], c);
+            }
+        }
+    }
+    std::vector<uint> caller_offsets(count + 1, 0), callers(edges.size());
+    auto waiting = std::make_unique<std::atomic<uint>[]>(count);
+    for (uint c = 0; c < count; ++c) {
+        waiting[c] = 0;
+    }
+    for (const auto& edge : edges) {
+        caller_offsets[edge.first + 1]++;
+        waiting[edge.second]++;
+    }
+    for (uint c = 0; c < count; ++c) {
+        caller_offsets[c + 1] += caller_offsets[c];
+    }
+    std::vector<uint> fill(caller_offsets.begin(), caller_offsets.end() - 1);
+    for (const auto& edge : edges) {
+        callers[fill[edge.first]++] = edge.second;
+    }
+
+    TaskScheduler scheduler(jobs);
+    std::atomic<std::size_t> reused {0};
+    std::function<void(uint)> visit = [&](uint component) {
+        if (this->solve(component, cache)) {
+            reused++;
+        }
+        for (uint i = caller_offsets[component]; i < caller_offsets[component + 1]; ++i) {
+            const uint caller = callers[i];
+            if (waiting[caller].fetch_sub(1) == 1) {
+                scheduler.push([&visit, caller]() { visit(caller); });
+            }
+        }
+    };
+    for (uint c = 0; c < count; ++c) {
+        if (waiting[c] == 0) {
+            scheduler.push([&visit, c]() { visit(c); });
+        }
+    }
+    scheduler.run();
+
+    for (uint f = 0; f < this->size(); ++f) {
+        this->symbol(f).set_registers(this->summaries[f]);
+    }
+    if (cache != nullptr) {
+        cache->clear();
+        for (uint f = 0; f < this->size(); ++f) {
+            cache->insert(this->keys[f], this->summaries[f]);
+        }
+    }
+
+    return SummaryStats {count - reused.load(), reused.load()};
+}
+
+std::size_t CallGraph::size() const {
+    return this->functions.size();
+}
+
+uint CallGraph::function_of(uint section, std::size_t symbol) const {
+    return this->first_function[section] + (uint)symbol;
+}
+
+Symbol& CallGraph::symbol(uint function) const {
+    const Function& entry = this->functions[function];
+    return this->sections[entry.section]->get_symbols()[entry.symbol];
+}
+
+EdgeSpan CallGraph::calls(uint function) const {
+    const uint first = this->call_offsets[function];
+    return EdgeSpan {this->call_targets.data() + first, this->call_offsets[function + 1] - first};
+}
+
+void CallGraph::callees(uint function, std::vector<Symbol*>& out) const {
+    const InstructionSpan instructions = this->symbol(function).instructions;
+    const EdgeSpan targets = this->calls(function);
+    out.assign(instructions.size(), nullptr);
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < instructions.size() && next < targets.size(); ++i) {
+        if (!branch_flow(instructions[i], i, instructions.size()).calls) {
+            continue;
+        }
+        const uint target = targets[next++];
+        out[i] = target == NONE ? nullptr : &this->symbol(target);
+    }
+}
+
+std::size_t CallGraph::num_components() const {
+    return this->component_offsets.size() - 1;
+}
+
+uint CallGraph::component_of(uint function) const {
+    return this->components[function];
+}
+
+EdgeSpan CallGraph::members(uint component) const {
+    const uint first = this->component_offsets[component];
+    return EdgeSpan {this->component_members.data() + first, this->component_offsets[component + 1] - first};
+}
+
+const FunctionRegisters& CallGraph::summary(uint function) const {
+    return this->summaries[function];
+}
+
+void CallGraph::call_summaries(uint function, std::vector<FunctionRegisters>& out) const {
+    out.clear();
+    for (uint target : this->calls(function)) {
+        out.push_back(target == NONE ? UNKNOWN_CALL : this->summaries[target]);
+    }
+}
+
+}
@@ -0,0 +1,256 @@
+
+#include <algorithm>
+
+#include "ppc/cfg.h"
+
+namespace PPC {
+
+// BO with both the condition and the counter ignored, the branch is always taken
+static bool always(const DecodedInstruction& inst) {
+    return (inst.rd & 0x14) == 0x14;
+}
+
+BranchFlow branch_flow(const DecodedInstruction& inst, std::size_t index, std::size_t count) {
+    BranchFlow out {true, false, false, -1};
+    const bool link = get_bit(inst.word, 31);
+
+    if (inst.opcode == 18 || inst.opcode == 16) {
+        if (link) {
+            out.calls = true;
+            return out;
+        }
+        const int offset = inst.opcode == 18 ? inst.branch_offset() : (int)(short)(inst.word & 0xFFFC);
+        const long target = (long)index + offset / 4;
+        out.next = inst.opcode == 16 && !always(inst);
+        if (!get_bit(inst.word, 30) && target >= 0 && (std::size_t)target < count) {
+            out.target = target;
+        } else {
+            out.exits = true;
+        }
+    } else if (inst.opcode == 19 && (inst.xo == 16 || inst.xo == 528)) {
+        if (link) {
+            out.calls = true;
+            return out;
+        }
+        out.exits = true;
+        out.next = !always(inst);
+    } else if (inst.opcode == 19 && inst.xo == 50) {
+        out.next = false;
+        out.exits = true;
+    }
+
+    return out;
+}
+
+int branch_address(const DecodedInstruction& inst, ulong address) {
+    const int offset = inst.opcode == 18 ? inst.branch_offset() : (int)(short)(inst.word & 0xFFFC);
+    return get_bit(inst.word, 30) ? offset : (int)address + offset;
+}
+
+ControlFlowGraph::ControlFlowGraph() = default;
+
+ControlFlowGraph::ControlFlowGraph(InstructionSpan instructions) {
+    this->build(instructions);
+}
+
+void ControlFlowGraph::build(InstructionSpan instructions) {
+    this->blocks.clear();
+    this->successor_offsets.assign(1, 0);
+    this->successor_edges.clear();
+    this->predecessor_offsets.assign(1, 0);
+    this->predecessor_edges.clear();
+    this->order.clear();
+    this->order_number.clear();
+    this->dominators.clear();
+    if (instructions.empty()) {
+        return;
+    }
+
+    this->find_blocks(instructions);
+    this->link_blocks(instructions);
+    this->find_order();
+    this->find_dominators();
+}
+
+void ControlFlowGraph::find_blocks(InstructionSpan instructions) {
+    const std::size_t count = instructions.size();
+    this->leaders.assign(count, false);
+    this->leaders[0] = true;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const BranchFlow flow = branch_flow(instructions[i], i, count);
+        if (flow.next && !flow.exits && flow.target < 0) {
+            continue;
+        }
+        if (i + 1 < count) {
+            this->leaders[i + 1] = true;
+        }
+        if (flow.target >= 0) {
+            this->leaders[flow.target] = true;
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (this->leaders[i]) {
+            this->blocks.push_back(Block {(uint)i, (uint)i, false});
+        }
+        this->blocks.back().last = (uint)i;
+    }
+}
+
+void ControlFlowGraph::link_blocks(InstructionSpan instructions) {
+    const std::size_t count = instructions.size();
+    const uint num_blocks = (uint)this->blocks.size();
+
+    for (uint b = 0; b < num_blocks; ++b) {
+        Block& block = this->blocks[b];
+        const BranchFlow flow = branch_flow(instructions[block.last], block.last, count);
+        // Running off the end is leaving, the splitter cut the function there
+        block.exits = flow.exits || (flow.next && block.last + 1 == count);
+        if (flow.next && block.last + 1 < count) {
+            this->successor_edges.push_back(b + 1);
+        }
+        if (flow.target >= 0) {
+            const uint target = this->block_of((std::size_t)flow.target);
+            if (!(flow.next && target == b + 1)) {
+                this->successor_edges.push_back(target);
+            }
+        }
+        this->successor_offsets.push_back((uint)this->successor_edges.size());
+    }
+
+    // Predecessors are the same edges turned around, counted first so each row is filled in place
+    this->predecessor_offsets.assign(num_blocks + 1, 0);
+    for (uint edge : this->successor_edges) {
+        this->predecessor_offsets[edge + 1]++;
+    }
+    for (uint b = 0; b < num_blocks; ++b) {
+        this->predecessor_offsets[b + 1] += this->predecessor_offsets[b];
+    }
+    this->predecessor_edges.resize(this->successor_edges.size());
+    this->stack.assign(this->predecessor_offsets.begin(), this->predecessor_offsets.end() - 1);
+    for (uint b = 0; b < num_blocks; ++b) {
+        for (uint next : this->successors(b)) {
+            this->predecessor_edges[this->stack[next]++] = b;
+        }
+    }
+}
+
+void ControlFlowGraph::find_order() {
+    // Depth first from the entry, the stack holds pairs of a block and the next of its edges to follow
+    this->order_number.assign(this->blocks.size(), NONE);
+    this->stack.clear();
+    this->stack.push_back(0);
+    this->stack.push_back(0);
+    this->order_number[0] = 0;
+
+    while (!this->stack.empty()) {
+        const uint block = this->stack[this->stack.size() - 2];
+        const EdgeSpan next = this->successors(block);
+        const uint edge = this->stack.back();
+        if (edge < next.size()) {
+            this->stack.back()++;
+            if (this->order_number[next[edge]] == NONE) {
+                this->order_number[next[edge]] = 0;
+                this->stack.push_back(next[edge]);
+                this->stack.push_back(0);
+            }
+        } else {
+            this->order.push_back(block);
+            this->stack.resize(this->stack.size() - 2);
+        }
+    }
+
+    std::reverse(this->order.begin(), this->order.end());
+    for (uint i = 0; i < this->order.size(); ++i) {
+        this->order_number[this->order[i]] = i;
+    }
+}
+
+uint ControlFlowGraph::intersect(uint first, uint second) const {
+    while (first != second) {
+        while (this->order_number[first] > this->order_number[second]) {
+            first = this->dominators[first];
+        }
+        while (this->order_number[second] > this->order_number[first]) {
+            second = this->dominators[second];
+        }
+    }
+    return first;
+}
+
+void ControlFlowGraph::find_dominators() {
+    // Cooper, Harvey and Kennedy's iteration, walking up the partial tree by reverse postorder number
+    this->dominators.assign(this->blocks.size(), NONE);
+    this->dominators[0] = 0;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = 1; i < this->order.size(); ++i) {
+            const uint block = this->order[i];
+            uint dominator = NONE;
+            for (uint prev : this->predecessors(block)) {
+                if (this->dominators[prev] == NONE) {
+                    continue;
+                }
+                dominator = dominator == NONE ? prev : this->intersect(prev, dominator);
+            }
+            if (this->dominators[block] != dominator) {
+                this->dominators[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+}
+
+std::size_t ControlFlowGraph::size() const {
+    return this->blocks.size();
+}
+
+const ControlFlowGraph::Block& ControlFlowGraph::operator[](uint block) const {
+    return this->blocks[block];
+}
+
+uint ControlFlowGraph::block_of(std::size_t instruction) const {
+    auto after = std::upper_bound(this->blocks.begin(), this->blocks.end(), instruction,
+                                  [](std::size_t index, const Block& block) { return index < block.first; });
+    return (uint)(after - this->blocks.begin()) - 1;
+}
+
+EdgeSpan ControlFlowGraph::successors(uint block) const {
+    const uint first = this->successor_offsets[block];
+    return EdgeSpan {this->successor_edges.data() + first, this->successor_offsets[block + 1] - first};
+}
+
+EdgeSpan ControlFlowGraph::predecessors(uint block) const {
+    const uint first = this->predecessor_offsets[block];
+    return EdgeSpan {this->predecessor_edges.data() + first, this->predecessor_offsets[block + 1] - first};
+}
+
+EdgeSpan ControlFlowGraph::reverse_postorder() const {
+    return EdgeSpan {this->order.data(), this->order.size()};
+}
+
+bool ControlFlowGraph::reachable(uint block) const {
+    return this->order_number[block] != NONE;
+}
+
+uint ControlFlowGraph::immediate_dominator(uint block) const {
+    return this->dominators[block];
+}
+
+bool ControlFlowGraph::dominates(uint dominator, uint block) const {
+    if (!this->reachable(dominator) || !this->reachable(block)) {
+        return false;
+    }
+    while (block != dominator) {
+        if (block == 0) {
+            return false;
+        }
+        block = this->dominators[block];
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,78 @@
+
+#include "ppc/code_section.h"
+#include "ppc/batch.h"
+#include "ppc/symbol_map.h"
+
+namespace PPC {
+
+CodeSection::CodeSection(ByteSpan code, ulong base) {
+    this->code = code;
+    this->base = base;
+    this->symbols_made = false;
+    this->inputs_made = false;
+    this->index_made = false;
+
+    DecodedBlock block;
+    decode_range(code.data, code.size, block);
+
+    DecodedInstruction *out = this->arena.allocate_array<DecodedInstruction>(block.size());
+    for (std::size_t i = 0; i < block.size(); ++i) {
+        out[i] = block.get(i);
+    }
+    this->decoded = InstructionSpan(out, block.size());
+}
+
+ByteSpan CodeSection::bytes() const {
+    return this->code;
+}
+
+ulong CodeSection::get_base() const {
+    return this->base;
+}
+
+InstructionSpan CodeSection::get_instructions() const {
+    return this->decoded;
+}
+
+std::size_t CodeSection::memory_used() const {
+    return this->arena.capacity() + this->symbols.capacity() * sizeof(Symbol) +
+           this->index.size() * (sizeof(SymbolIndex::Entry) + sizeof(ulong) + sizeof(uint));
+}
+
+std::vector<Symbol>& CodeSection::get_symbols() {
+    if (!this->symbols_made) {
+        this->symbols = generate_symbols(this->decoded, this->arena, this->base);
+        this->symbols_made = true;
+    }
+    return this->symbols;
+}
+
+std::vector<Symbol>& CodeSection::get_symbols_with_inputs(uint jobs) {
+    std::vector<Symbol>& out = this->get_symbols();
+    if (!this->inputs_made) {
+        generate_inputs(out, jobs);
+        this->inputs_made = true;
+    }
+    return out;
+}
+
+const SymbolIndex& CodeSection::get_symbol_index() {
+    if (!this->index_made) {
+        this->index = SymbolIndex(this->get_symbols());
+        this->index_made = true;
+    }
+    return this->index;
+}
+
+void CodeSection::name_symbols(const SymbolMap& map, ulong address) {
+    for (auto& symbol : this->get_symbols()) {
+        const SymbolMapRecord *record = map.find(address + (symbol.start - this->base));
+        if (record != nullptr) {
+            symbol.name = this->arena.copy(map.name(*record));
+        }
+    }
+    // The index keeps views of the old names
+    this->index_made = false;
+}
+
+}
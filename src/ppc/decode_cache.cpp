@@ -0,0 +1,95 @@
+
+#include <atomic>
+#include <vector>
+
+#include "ppc/decode_cache.h"
+
+namespace PPC {
+
+static constexpr uint CACHE_BITS = 11;
+static constexpr uint CACHE_SIZE = 1u << CACHE_BITS;
+
+static std::atomic<bool> cache_enabled {false};
+static std::atomic<ulong> total_hits {0};
+static std::atomic<ulong> total_misses {0};
+
+struct DecodeCache {
+
+    std::vector<CachedInstruction> entries;
+    ulong hits = 0;
+    ulong misses = 0;
+
+    ~DecodeCache() {
+        total_hits += hits;
+        total_misses += misses;
+    }
+
+};
+
+static thread_local DecodeCache cache;
+
+static void fill(CachedInstruction& entry, const DecodedInstruction& inst) {
+    entry.decoded = inst;
+    entry.operand_length = (uchar)format_operands(entry.decoded, entry.operands);
+    entry.valid = true;
+}
+
+void set_decode_cache(bool enabled) {
+    cache_enabled = enabled;
+}
+
+bool decode_cache_enabled() {
+    return cache_enabled;
+}
+
+// The entry for word, which needs filling if it isn't valid
+static CachedInstruction* find_entry(uint word) {
+    static thread_local CachedInstruction scratch;
+    if (!cache_enabled) {
+        scratch.valid = false;
+        return &scratch;
+    }
+
+    if (cache.entries.empty()) {
+        cache.entries.resize(CACHE_SIZE);
+    }
+
+    // Fibonacci hashing, common words differ mostly in their low immediate bits
+    CachedInstruction& entry = cache.entries[(word * 0x9E3779B1u) >> (32 - CACHE_BITS)];
+    if (entry.valid && entry.decoded.word == word) {
+        cache.hits++;
+        return &entry;
+    }
+    cache.misses++;
+    entry.valid = false;
+    return &entry;
+}
+
+const CachedInstruction& decode_cached(uint word) {
+    CachedInstruction *entry = find_entry(word);
+    if (!entry->valid) {
+        fill(*entry, decode(word));
+    }
+    return *entry;
+}
+
+const CachedInstruction& decode_cached(const DecodedInstruction& inst) {
+    CachedInstruction *entry = find_entry(inst.word);
+    if (!entry->valid) {
+        fill(*entry, inst);
+    }
+    return *entry;
+}
+
+CacheStats decode_cache_stats() {
+    return CacheStats {total_hits + cache.hits, total_misses + cache.misses};
+}
+
+void reset_decode_cache_stats() {
+    total_hits = 0;
+    total_misses = 0;
+    cache.hits = 0;
+    cache.misses = 0;
+}
+
+}
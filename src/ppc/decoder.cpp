@@ -0,0 +1,409 @@
+
+#include "ppc/codes.h"
+#include "ppc/decoder.h"
+#include "ppc/decode_cache.h"
+#include "ppc/operands.h"
+
+namespace PPC {
+
+ushort extended_opcode(uchar opcode, uint word) {
+    switch (opcode) {
+        case 4: {
+            ushort ttype = (ushort)get_bits(word, 21, 30);
+            ushort stype = (ushort)get_bits(word, 26, 30);
+            if (secondary_codes_ps.contains(ttype)) {
+                return ttype;
+            } else if (secondary_codes_ps.contains(stype)) {
+                return stype;
+            }
+            return DecodedInstruction::NO_XO;
+        }
+        case 19:
+        case 31:
+            return (ushort)get_bits(word, 21, 30);
+        case 59:
+            return (ushort)get_bits(word, 26, 30);
+        case 63:
+            if (get_bit(word, 26)) {
+                return (ushort)get_bits(word, 26, 30);
+            }
+            return (ushort)get_bits(word, 21, 30);
+        default:
+            return DecodedInstruction::NO_XO;
+    }
+}
+
+DecodedInstruction decode(uint word) {
+    DecodedInstruction out {};
+    out.word = word;
+    out.opcode = (uchar)get_bits(word, 0, 5);
+    out.rd = (uchar)get_bits(word, 6, 10);
+    out.ra = (uchar)get_bits(word, 11, 15);
+    out.rb = (uchar)get_bits(word, 16, 20);
+    out.rc = (uchar)get_bits(word, 21, 25);
+    out.imm = (ushort)get_bits(word, 16, 31);
+    out.xo = extended_opcode(out.opcode, word);
+    resolve_mnemonic(out);
+    return out;
+}
+
+DecodedInstruction decode(const uchar *instruction) {
+    return decode(read_word(instruction));
+}
+
+bool has_destination(const DecodedInstruction& inst) {
+    if (primary_missing_dest.contains(inst.opcode)) {
+        return false;
+    } else if (inst.opcode == 31) {
+        return !secondary_missing_dest_math.contains(inst.xo);
+    } else if (inst.opcode == 63) {
+        return !secondary_missing_dest_double.contains(inst.xo);
+    }
+    return true;
+}
+
+uint register_roles(const DecodedInstruction& inst) {
+    switch (inst.opcode) {
+        case 4: {
+            uint roles = secondary_roles_ps[inst.xo];
+            if ((inst.xo == 6 || inst.xo == 7) && get_bit(inst.word, 25)) {
+                roles = (roles & ~A_BASE) | A_UPDATE;
+            }
+            return roles;
+        }
+        case 19:
+            return secondary_roles_sb[inst.xo];
+        case 31:
+            return secondary_roles_math[inst.xo];
+        case 59:
+            return secondary_roles_float[inst.xo];
+        case 63:
+            return secondary_roles_double[inst.xo];
+        default:
+            return primary_roles[inst.opcode];
+    }
+}
+
+template<std::size_t N>
+static std::string_view lookup(const CodeTable<N>& table, ulong key, std::string_view fallback) {
+    std::string_view found = table[key];
+    return found.empty() ? fallback : found;
+}
+
+static ulong spr_number(const DecodedInstruction& inst) {
+    return inst.ra + ((ulong)inst.rb << 5);
+}
+
+static Mnemonic ps_variant(const DecodedInstruction& inst) {
+    const uint word = inst.word;
+    const bool b24 = get_bit(word, 24), b25 = get_bit(word, 25);
+    switch (inst.xo) {
+        case 0:
+            if (b24) {
+                return b25 ? Mnemonic::PS_CMPO1 : Mnemonic::PS_CMPU1;
+            }
+            return b25 ? Mnemonic::PS_CMPO0 : Mnemonic::PS_CMPU0;
+        case 6:
+            return b25 ? Mnemonic::PS_LUX : Mnemonic::PS_LX;
+        case 7:
+            return b25 ? Mnemonic::PS_STUX : Mnemonic::PS_STX;
+        case 16:
+            if (b24) {
+                return b25 ? Mnemonic::PS_MERGE11 : Mnemonic::PS_MERGE10;
+            }
+            return b25 ? Mnemonic::PS_MERGE01 : Mnemonic::PS_MERGE00;
+        default:
+            return secondary_codes_ps[inst.xo];
+    }
+}
+
+static Mnemonic spr_variant(const DecodedInstruction& inst, Mnemonic fallback) {
+    const bool from = inst.xo == 339;
+    switch (spr_number(inst)) {
+        case 0b1:
+            return from ? Mnemonic::MFXER : Mnemonic::MTXER;
+        case 0b01000:
+            return from ? Mnemonic::MFLR : Mnemonic::MTLR;
+        case 0b01001:
+            return from ? Mnemonic::MFCTR : Mnemonic::MTCTR;
+        default:
+            return fallback;
+    }
+}
+
+static Mnemonic branch_register_variant(const DecodedInstruction& inst, Mnemonic fallback) {
+    const bool to_lr = inst.xo == 16;
+    if (inst.rd == 20) {
+        return to_lr ? Mnemonic::BLR : Mnemonic::BCTR;
+    } else if (inst.rd == 12 && inst.ra == 0) {
+        return to_lr ? Mnemonic::BLTLR : Mnemonic::BLTCTR;
+    } else if (inst.rd == 16 && inst.ra == 0) {
+        return to_lr ? Mnemonic::BDNZLR : Mnemonic::BDNZCTR;
+    }
+    return fallback;
+}
+
+template<std::size_t N>
+static Mnemonic lookup(const CodeTable<N, Mnemonic>& table, ulong key, Mnemonic fallback) {
+    Mnemonic found = table[key];
+    return found == Mnemonic::NONE ? fallback : found;
+}
+
+void resolve_mnemonic(DecodedInstruction& inst) {
+    const uint word = inst.word;
+    const bool record = get_bit(word, 31);
+    Mnemonic mnemonic = lookup(primary_codes, inst.opcode, Mnemonic::UNKNOWN_INSTRUCTION);
+    uchar suffix = DecodedInstruction::NONE;
+
+    switch (inst.opcode) {
+        case 0:
+            if (get_bits(word, 6, 31) == 0) {
+                mnemonic = Mnemonic::PADDING;
+            }
+            break;
+        case 4:
+            if (inst.xo != DecodedInstruction::NO_XO) {
+                // Variants only apply when matched on the short-form code
+                if (get_bits(word, 21, 30) != inst.xo) {
+                    mnemonic = ps_variant(inst);
+                } else {
+                    mnemonic = secondary_codes_ps[inst.xo];
+                }
+            }
+            if (record) {
+                suffix |= DecodedInstruction::RECORD;
+            }
+            break;
+        case 10:
+            if (!get_bit(word, 10)) {
+                mnemonic = Mnemonic::CMPLWI;
+            }
+            break;
+        case 11:
+            if (!get_bit(word, 10)) {
+                mnemonic = Mnemonic::CMPWI;
+            }
+            break;
+        case 12:
+            if (inst.simm() < 0) {
+                mnemonic = Mnemonic::SUBIC;
+            }
+            break;
+        case 15:
+            if (inst.simm() < 0) {
+                mnemonic = Mnemonic::SUBIS;
+            }
+            break;
+        case 16:
+        case 18:
+            if (record) {
+                suffix |= DecodedInstruction::LINK;
+            }
+            if (get_bit(word, 30)) {
+                suffix |= DecodedInstruction::ABSOLUTE;
+            }
+            if (inst.opcode == 16) {
+                if (inst.rd == 12 && inst.ra == 0) {
+                    mnemonic = Mnemonic::BLT;
+                } else if (inst.rd == 4 && inst.ra == 10) {
+                    mnemonic = Mnemonic::BNE;
+                }
+            }
+            break;
+        case 19:
+            mnemonic = lookup(secondary_codes_sb, inst.xo, mnemonic);
+            if (inst.xo == 16 || inst.xo == 528) {
+                mnemonic = branch_register_variant(inst, mnemonic);
+                if (record) {
+                    suffix |= DecodedInstruction::LINK;
+                }
+            }
+            break;
+        case 23:
+            if (record) {
+                suffix |= DecodedInstruction::RECORD;
+            }
+            break;
+        case 24:
+            if (get_bits(word, 6, 31) == 0) {
+                mnemonic = Mnemonic::NOP;
+            }
+            break;
+        case 31:
+            mnemonic = lookup(secondary_codes_math, inst.xo, mnemonic);
+            if (inst.xo == 0 || inst.xo == 32) {
+                if (!get_bit(word, 10)) {
+                    mnemonic = inst.xo == 0 ? Mnemonic::CMPW : Mnemonic::CMPLW;
+                }
+            } else if (inst.xo == 124) {
+                if (inst.rd == inst.rb) {
+                    mnemonic = Mnemonic::NOT;
+                }
+            } else if (inst.xo == 144) {
+                if (get_bits(word, 12, 19) == 0xFF) {
+                    mnemonic = Mnemonic::MTCR;
+                }
+            } else if (inst.xo == 339 || inst.xo == 467) {
+                mnemonic = spr_variant(inst, mnemonic);
+            } else if (inst.xo == 371) {
+                if (spr_number(inst) == 0b0100001101) {
+                    mnemonic = Mnemonic::MFTBU;
+                }
+            } else if (inst.xo == 444) {
+                if (inst.rd == inst.rb) {
+                    mnemonic = Mnemonic::MR;
+                }
+            }
+            if (record) {
+                suffix |= DecodedInstruction::RECORD;
+            }
+            break;
+        case 59:
+            mnemonic = lookup(secondary_codes_float, inst.xo, mnemonic);
+            if (record) {
+                suffix |= DecodedInstruction::RECORD;
+            }
+            break;
+        case 63:
+            mnemonic = lookup(secondary_codes_double, inst.xo, mnemonic);
+            if (record) {
+                suffix |= DecodedInstruction::RECORD;
+            }
+            break;
+        default:
+            break;
+    }
+
+    inst.mnemonic = mnemonic;
+    inst.suffix = suffix;
+}
+
+std::size_t format_code_name(const DecodedInstruction& inst, char *out) {
+    std::string_view name = mnemonic_name(inst.mnemonic);
+    std::size_t length = name.copy(out, name.length());
+    if (inst.suffix & DecodedInstruction::LINK) {
+        out[length++] = 'l';
+    }
+    if (inst.suffix & DecodedInstruction::ABSOLUTE) {
+        out[length++] = 'a';
+    }
+    if (inst.suffix & DecodedInstruction::RECORD) {
+        out[length++] = '.';
+    }
+    return length;
+}
+
+std::string code_name(const DecodedInstruction& inst) {
+    char buffer[MAX_CODE_NAME];
+    return std::string(buffer, format_code_name(inst, buffer));
+}
+
+std::string_view operand_pattern(const DecodedInstruction& inst) {
+    const uint word = inst.word;
+    std::string_view pattern = lookup(primary_patterns, inst.opcode, pattern_unknown);
+
+    switch (inst.opcode) {
+        case 0:
+            if (get_bits(word, 6, 31) == 0) {
+                pattern = pattern_none;
+            }
+            break;
+        case 4:
+            if (inst.xo != DecodedInstruction::NO_XO) {
+                pattern = lookup(secondary_patterns_ps, inst.xo, pattern);
+            }
+            break;
+        case 10:
+        case 11:
+            if (!get_bit(word, 10)) {
+                pattern = pattern_cmp_imm_word;
+            } else {
+                pattern = pattern_cmp_imm;
+            }
+            break;
+        case 12:
+        case 15:
+            if (inst.simm() < 0) {
+                pattern = pattern_sub_imm;
+            } else {
+                pattern = pattern_add_imm;
+            }
+            break;
+        case 16:
+            if ((inst.rd == 12 && inst.ra == 0) || (inst.rd == 4 && inst.ra == 10)) {
+                pattern = pattern_branch_cond;
+            }
+            break;
+        case 19:
+            pattern = lookup(secondary_patterns_sb, inst.xo, pattern);
+            if (inst.xo == 16 || inst.xo == 528) {
+                pattern = pattern_branch_reg;
+                if (inst.rd == 20 || ((inst.rd == 12 || inst.rd == 16) && inst.ra == 0)) {
+                    pattern = pattern_none;
+                }
+            }
+            break;
+        case 24:
+            if (get_bits(word, 6, 31) == 0) {
+                pattern = pattern_none;
+            }
+            break;
+        case 31:
+            pattern = lookup(secondary_patterns_math, inst.xo, pattern);
+            if (inst.xo == 0 || inst.xo == 32) {
+                if (!get_bit(word, 10)) {
+                    pattern = pattern_cmp_word;
+                } else {
+                    pattern = pattern_cmp;
+                }
+            } else if (inst.xo == 124 || inst.xo == 444) {
+                if (inst.rd == inst.rb) {
+                    pattern = pattern_move;
+                }
+            } else if (inst.xo == 144) {
+                if (get_bits(word, 12, 19) == 0xFF) {
+                    pattern = pattern_single;
+                } else {
+                    pattern = pattern_mtcrf;
+                }
+            } else if (inst.xo == 339 || inst.xo == 467) {
+                ulong reg = spr_number(inst);
+                if (reg == 0b1 || reg == 0b01000 || reg == 0b01001) {
+                    pattern = pattern_single;
+                } else if (inst.xo == 339) {
+                    pattern = pattern_from_spr;
+                } else {
+                    pattern = pattern_to_spr;
+                }
+            } else if (inst.xo == 371) {
+                ulong reg = spr_number(inst);
+                if (reg == 0b0100001100 || reg == 0b0100001101) {
+                    pattern = pattern_single;
+                } else {
+                    pattern = pattern_to_spr;
+                }
+            }
+            break;
+        case 59:
+            pattern = lookup(secondary_patterns_float, inst.xo, pattern);
+            break;
+        case 63:
+            pattern = lookup(secondary_patterns_double, inst.xo, pattern);
+            break;
+        default:
+            break;
+    }
+
+    return pattern;
+}
+
+std::string code_pattern(const DecodedInstruction& inst) {
+    return std::string(operand_pattern(inst));
+}
+
+std::string get_variables(const DecodedInstruction& inst) {
+    const CachedInstruction& cached = decode_cached(inst);
+    return std::string(cached.operands, cached.operand_length);
+}
+
+}
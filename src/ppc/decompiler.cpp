@@ -1,9 +1,16 @@
 
 #include "ppc/decompiler.h"
 #include "ppc/symbol.h"
+#include "ppc/code_section.h"
 #include "ppc/instruction.h"
+#include "ppc/decode_cache.h"
+#include "ppc/ssa.h"
+#include "ppc/call_graph.h"
+#include "parallel.h"
 
+#include <atomic>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <vector>
 #include <at_logging>
@@ -14,59 +21,375 @@ using std::ios;
 
 static logging::Logger* logger = logging::get_logger("ppc.decomp");
 
-void decompile(const std::string& file_in, const std::string& file_out, int start, int end) {
+// What a function gives back, as its signature says
+enum class ReturnType { VOID, INT, FLOAT };
+
+static void write_hex(std::ostream& output, long value) {
+    if (value < 0) {
+        output << "-";
+        value = -value;
+    }
+    if (value < 10) {
+        output << value;
+    } else {
+        output << "0x" << std::hex << value << std::dec;
+    }
+}
+
+// Arguments go by their register, constants by their value, everything else by its number
+static void write_value(std::ostream& output, const SSAFunction& ir, ValueId id) {
+    const Value& value = ir[id];
+    switch (value.op) {
+        case Op::ARGUMENT:
+            if (value.variable < FPR_VARIABLE) {
+                output << "r" << (int)value.variable;
+            } else {
+                output << "fr" << (int)(value.variable - FPR_VARIABLE);
+            }
+            break;
+        case Op::CONSTANT:
+            write_hex(output, value.constant);
+            break;
+        case Op::UNDEFINED:
+            output << "undefined";
+            break;
+        default:
+            output << "v" << id;
+    }
+}
+
+static const char *type_name(const Value& value) {
+    switch (value.type) {
+        case ValueType::INT:
+            if (value.op == Op::LOAD || value.op == Op::STORE) {
+                switch (value.width) {
+                    case 1: return "uint8_t";
+                    case 2: return value.constant ? "int16_t" : "uint16_t";
+                }
+            }
+            return "int32_t";
+        case ValueType::FLOAT:
+            return value.width == 8 ? "double" : "float";
+        case ValueType::CONDITION:
+            return "int";
+        default:
+            return "void";
+    }
+}
+
+static void write_address(std::ostream& output, const SSAFunction& ir, EdgeSpan operands) {
+    const ValueId base = operands[operands.size() - 2], offset = operands[operands.size() - 1];
+    const bool no_base = ir[base].op == Op::CONSTANT && ir[base].constant == 0;
+    const bool no_offset = ir[offset].op == Op::CONSTANT && ir[offset].constant == 0;
+    output << "(";
+    if (!no_base || no_offset) {
+        write_value(output, ir, base);
+    }
+    if (!no_base && !no_offset && ir[offset].op == Op::CONSTANT && ir[offset].constant < 0) {
+        output << " - ";
+        write_hex(output, -(long)ir[offset].constant);
+    } else if (!no_offset) {
+        output << (no_base ? "" : " + ");
+        write_value(output, ir, offset);
+    }
+    output << ")";
+}
+
+// The test of a bc, given BO << 5 | BI, on the CR field compared with 0 like a three way compare
+static void write_condition(std::ostream& output, const SSAFunction& ir, ValueId field, int bits) {
+    const uint bo = (uint)bits >> 5, bi = (uint)bits & 3;
+    const bool counter = !(bo & 0x04), test = !(bo & 0x10);
+    if (counter) {
+        output << ((bo & 0x02) ? "--ctr == 0" : "--ctr != 0");
+        if (test) {
+            output << " && ";
+        }
+    }
+    if (test) {
+        static const char *taken[] = {" < 0", " > 0", " == 0", ""};
+        static const char *not_taken[] = {" >= 0", " <= 0", " != 0", ""};
+        if (bi == 3) {
+            output << ((bo & 0x08) ? "unordered(" : "!unordered(");
+        }
+        write_value(output, ir, field);
+        output << (bi == 3 ? ")" : (bo & 0x08) ? taken[bi] : not_taken[bi]);
+    }
+}
+
+static void write_return(std::ostream& output, const SSAFunction& ir, EdgeSpan operands, ReturnType type) {
+    if (type == ReturnType::VOID) {
+        output << "return;\n";
+        return;
+    }
+    output << "return ";
+    write_value(output, ir, operands[operands.size() - (type == ReturnType::INT ? 2 : 1)]);
+    output << ";\n";
+}
+
+static void write_call(std::ostream& output, const SSAFunction& ir, ValueId id, std::vector<Symbol>& symbols,
+                       const SymbolIndex& names, Symbol *const *callees) {
+    const Value& call = ir[id];
+    const EdgeSpan arguments = ir.operands(id);
+    // The call graph knows where calls between sections land, the rest are looked up in this section
+    Symbol *callee = callees[call.instruction];
+    const SymbolIndex::Entry *target = call.constant ? names.at((ulong)(uint)call.constant) : nullptr;
+
+    // A known callee only gets what it takes, otherwise every argument register that holds something
+    uint r_input = ~0u, fr_input = ~0u;
+    if (callee != nullptr) {
+        output << callee->name;
+        r_input = callee->get_input_regular();
+        fr_input = callee->get_input_float();
+    } else if (call.constant == 0) {
+        output << "(*ctr)";
+    } else if (target != nullptr && target->start == (ulong)(uint)call.constant) {
+        output << target->name;
+        r_input = symbols[target->id].get_input_regular();
+        fr_input = symbols[target->id].get_input_float();
+    } else {
+        output << "f_" << std::hex << (uint)call.constant << std::dec;
+    }
+
+    output << "(";
+    bool start = true;
+    for (uint i = 0; i < arguments.size(); ++i) {
+        const bool wanted = i < 8 ? r_input & (1u << (3 + i)) : fr_input & (1u << (i - 7));
+        if (!wanted || ir[arguments[i]].op == Op::UNDEFINED) {
+            continue;
+        }
+        if (!start) {
+            output << ", ";
+        }
+        start = false;
+        write_value(output, ir, arguments[i]);
+    }
+    output << ")";
+}
+
+/**
+ * Write the body of a function from its IR, a statement per value. Blocks get labels and gotos,
+ * phis are left as phi(), one operand per predecessor. Values nothing uses and that do nothing else
+ * are left out.
+ */
+static void write_body(std::ostream& output, const SSAFunction& ir, InstructionSpan instructions,
+                       std::vector<Symbol>& symbols, const SymbolIndex& names, Symbol *const *callees,
+                       ReturnType returns) {
+    static const char *operators[] = {" + ", " - ", " * ", " / ", " & ", " | ", " ^ ", " << ", " >> "};
+    const ControlFlowGraph& graph = ir.get_graph();
+
+    // Returns hand back at most the one register the signature says
+    std::vector<uint> uses(ir.size(), 0);
+    for (ValueId id = 0; id < ir.size(); ++id) {
+        const EdgeSpan operands = ir.operands(id);
+        std::size_t count = operands.size();
+        if (ir[id].op == Op::RETURN || ir[id].op == Op::RETURN_IF) {
+            count -= 2;
+            if (returns != ReturnType::VOID) {
+                uses[operands[operands.size() - (returns == ReturnType::INT ? 2 : 1)]]++;
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            uses[operands[i]]++;
+        }
+    }
+
+    for (uint b = 0; b < graph.size(); ++b) {
+        if (!graph.reachable(b)) {
+            continue;
+        }
+        if (!graph.predecessors(b).empty()) {
+            output << "block_" << b << ":\n";
+        }
+        const SSABlock& block = ir.block(b);
+        // Where control goes after this block without a goto
+        uint after = b + 1;
+        while (after < graph.size() && !graph.reachable(after)) {
+            after++;
+        }
+
+        auto write_values = [&](uint first, uint count) {
+            for (ValueId id = first; id < first + count; ++id) {
+                const Value& value = ir[id];
+                const EdgeSpan operands = ir.operands(id);
+                const bool pure = value.op != Op::STORE && value.op != Op::CALL && value.op != Op::OPAQUE &&
+                                  value.op < Op::JUMP;
+                if (value.op == Op::CONSTANT || (pure && uses[id] == 0)) {
+                    continue;
+                }
+                if (value.op == Op::JUMP && graph.successors(b)[0] == after) {
+                    continue;
+                }
+
+                output << "    ";
+                if (value.type != ValueType::NONE && value.op != Op::STORE) {
+                    output << type_name(value) << " v" << id << " = ";
+                }
+                switch (value.op) {
+                    case Op::PHI:
+                        output << "phi(";
+                        for (uint i = 0; i < operands.size(); ++i) {
+                            output << (i ? ", " : "");
+                            write_value(output, ir, operands[i]);
+                        }
+                        output << ")";
+                        break;
+                    case Op::RESULT:
+                        output << "result(";
+                        write_value(output, ir, operands[0]);
+                        output << ")";
+                        break;
+                    case Op::NEGATE:
+                        output << "-";
+                        write_value(output, ir, operands[0]);
+                        break;
+                    case Op::LOAD:
+                        output << "*(" << type_name(value) << "*)";
+                        write_address(output, ir, operands);
+                        break;
+                    case Op::STORE:
+                        output << "*(" << type_name(value) << "*)";
+                        write_address(output, ir, operands);
+                        output << " = ";
+                        write_value(output, ir, operands[0]);
+                        break;
+                    case Op::COMPARE:
+                        output << (value.constant ? "compare_logical(" : "compare(");
+                        write_value(output, ir, operands[0]);
+                        output << ", ";
+                        write_value(output, ir, operands[1]);
+                        output << ")";
+                        break;
+                    case Op::CALL:
+                        write_call(output, ir, id, symbols, names, callees);
+                        break;
+                    case Op::OPAQUE: {
+                        const DecodedInstruction& inst = instructions[value.instruction];
+                        const CachedInstruction& cached = decode_cached(inst);
+                        char name[MAX_CODE_NAME];
+                        output << "__asm(\"" << std::string_view(name, format_code_name(inst, name)) << " "
+                               << std::string_view(cached.operands, cached.operand_length) << "\")";
+                        break;
+                    }
+                    case Op::JUMP:
+                        output << "goto block_" << graph.successors(b)[0];
+                        break;
+                    case Op::BRANCH:
+                        output << "if (";
+                        write_condition(output, ir, operands[0], value.constant);
+                        output << ") goto block_" << graph.successors(b)[1] << ";\n";
+                        if (graph.successors(b)[0] != after) {
+                            output << "    goto block_" << graph.successors(b)[0] << ";\n";
+                        }
+                        continue;
+                    case Op::RETURN:
+                        write_return(output, ir, operands, returns);
+                        continue;
+                    case Op::RETURN_IF:
+                        output << "if (";
+                        write_condition(output, ir, operands[0], value.constant);
+                        output << ") ";
+                        write_return(output, ir, operands, returns);
+                        continue;
+                    default: {
+                        const Value& right = ir[operands[1]];
+                        write_value(output, ir, operands[0]);
+                        // Like addresses, r1 + -0x10 is written r1 - 0x10
+                        if ((value.op == Op::ADD || value.op == Op::SUB) && right.op == Op::CONSTANT &&
+                            right.constant < 0) {
+                            output << (value.op == Op::ADD ? " - " : " + ");
+                            write_hex(output, -(long)right.constant);
+                        } else {
+                            output << operators[(int)value.op - (int)Op::ADD];
+                            write_value(output, ir, operands[1]);
+                        }
+                        break;
+                    }
+                }
+                output << ";\n";
+            }
+        };
+        write_values(block.first_phi, block.num_phis);
+        write_values(block.first_value, block.num_values);
+    }
+}
+
+// Signature and body of one function, ir is reused between calls. callees is what CallGraph::callees gives
+static void write_function(std::ostream& output, Symbol& symbol, std::vector<Symbol>& symbols,
+                           const SymbolIndex& names, SSAFunction& ir, const FunctionRegisters *calls,
+                           Symbol *const *callees) {
+    logger->debug(std::string(symbol.name));
+    
+    bool start = true;
+    
+    // r3 takes precedence, a function that sets both has most likely just used fr1 as scratch
+    ReturnType returns = ReturnType::VOID;
+    if (symbol.get_output_regular() & (1u << 3)) {
+        returns = ReturnType::INT;
+        output << "int32_t ";
+    } else if (symbol.get_output_float() & (1u << 1)) {
+        returns = ReturnType::FLOAT;
+        output << "float ";
+    } else {
+        output << "void ";
+    }
+    output << symbol.name << "(";
+    const uint r_input = symbol.get_input_regular(), fr_input = symbol.get_input_float();
+    for (uint r = 0; r < 32; ++r) {
+        if (!(r_input & (1u << r))) {
+            continue;
+        }
+        if (!start) {
+            output << ", ";
+        } else {
+            start = false;
+        }
+        output << "int32_t r" << r;
+    }
+    for (uint r = 0; r < 32; ++r) {
+        if (!(fr_input & (1u << r))) {
+            continue;
+        }
+        if (!start) {
+            output << ", ";
+        } else {
+            start = false;
+        }
+        output << "float fr" << r;
+    }
+    output << ") {\n";
+    
+    ir.build(symbol.instructions, symbol.start, calls);
+    write_body(output, ir, symbol.instructions, symbols, names, callees, returns);
+    
+    output << "}\n";
+}
+
+void decompile(CodeSection& section, const std::string& file_out, uint jobs) {
     logger->info("Decompiling PPC");
     
-    std::fstream input(file_in, ios::in | ios::binary);
     std::fstream output(file_out, ios::out);
     
     uint position = 0;
     
-    if (end == -1) {
-        input.seekg(0, ios::end);
-        end = (int)input.tellg();
-    }
-    int size = end - start;
+    ulong size = section.bytes().size;
     uchar instruction[4];
     
-    input.seekg(start, ios::beg);
-    
     // New way
     
-    std::vector<Symbol> symbols = generate_symbols(file_in, start, end);
-    generate_inputs(symbols);
+    // Inputs and outputs come from the callees up, so calls are written with what their targets take
+    CallGraph graph(std::vector<CodeSection*> {&section});
+    graph.summarize(jobs);
+    std::vector<Symbol>& symbols = section.get_symbols();
+    const SymbolIndex& names = section.get_symbol_index();
+    // One IR reused for every function, its arena stays the size of the biggest
+    SSAFunction ir;
+    std::vector<FunctionRegisters> calls;
+    std::vector<Symbol*> callees;
     
-    for (auto& symbol : symbols) {
-        logger->debug(symbol.name);
-        
-        bool start = true;
-        
-        output << "void " << symbol.name << "(";
-        for (auto r : symbol.get_input_regular()) {
-            if (!start) {
-                output << ", ";
-            } else {
-                start = false;
-            }
-            output << "int32_t r" << r.number;
-        }
-        for (auto r : symbol.get_input_float()) {
-            if (!start) {
-                output << ", ";
-            } else {
-                start = false;
-            }
-            output << "float fr" << r.number;
-        }
-        output << ") {\n";
-        
-        for (auto i : symbol.instructions) {
-//            if (i->code_name() == "bl") {
-//                output << "" << ";";
-//            }
-        }
-        
-        output << "}\n";
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        graph.call_summaries(graph.function_of(0, i), calls);
+        graph.callees(graph.function_of(0, i), callees);
+        write_function(output, symbols[i], symbols, names, ir, calls.data(), callees.data());
     }
     
     // Old way
@@ -188,4 +511,104 @@ void decompile(const std::string& file_in, const std::string& file_out, int star
     logger->info("PPC decompile finished");
 }
 
+void decompile(ByteSpan code, const std::string& file_out, ulong base, uint jobs) {
+    CodeSection section(code, base);
+    decompile(section, file_out, jobs);
+}
+
+// A unit of a batch while its functions are out on the workers
+struct UnitState {
+    const DecompileUnit *unit;
+    std::unique_ptr<CodeSection> section;
+    // Text of each function, in symbol order
+    std::vector<std::string> functions;
+    // Functions not yet written, the task that writes the last one writes the file
+    std::atomic<std::size_t> remaining;
+};
+
+static void write_unit(UnitState& state) {
+    std::fstream output(state.unit->file_out, ios::out);
+    for (const auto& function : state.functions) {
+        output << function;
+    }
+    output.close();
+    
+    state.functions = std::vector<std::string>();
+    state.section.reset();
+}
+
+void decompile(const std::vector<DecompileUnit>& units, uint jobs, SummaryCache *cache) {
+    logger->info("Decompiling PPC");
+    
+    TaskScheduler scheduler(jobs);
+    std::vector<UnitState> states(units.size());
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        states[i].unit = &units[i];
+        scheduler.push([&states, i]() {
+            UnitState& state = states[i];
+            state.section = std::make_unique<CodeSection>(state.unit->code, state.unit->base);
+            if (state.unit->names != nullptr) {
+                state.section->name_symbols(*state.unit->names, state.unit->address);
+            }
+            state.section->get_symbol_index();
+        });
+    }
+    scheduler.run();
+    
+    // Summaries need every callee done first, so all units go through the call graph before any text
+    std::vector<CodeSection*> sections;
+    std::vector<ulong> addresses;
+    for (auto& state : states) {
+        sections.push_back(state.section.get());
+        addresses.push_back(state.unit->address);
+    }
+    CallGraph graph(sections, addresses);
+    const SummaryStats stats = graph.summarize(scheduler.size(), cache);
+    logger->info("Summarized " + std::to_string(stats.computed + stats.reused) + " call graph components, " +
+                 std::to_string(stats.reused) + " from cache");
+    
+    for (uint u = 0; u < states.size(); ++u) {
+        UnitState& state = states[u];
+        const std::size_t count = state.section->get_symbols().size();
+        state.functions.resize(count);
+        state.remaining = count;
+        if (count == 0) {
+            write_unit(state);
+            continue;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            scheduler.push([&graph, &state, u, i]() {
+                // One IR per worker, its arena stays the size of the biggest function that worker saw
+                static thread_local SSAFunction ir;
+                static thread_local std::vector<FunctionRegisters> calls;
+                static thread_local std::vector<Symbol*> callees;
+                std::vector<Symbol>& symbols = state.section->get_symbols();
+                graph.call_summaries(graph.function_of(u, i), calls);
+                graph.callees(graph.function_of(u, i), callees);
+                std::ostringstream text;
+                write_function(text, symbols[i], symbols, state.section->get_symbol_index(), ir, calls.data(),
+                               callees.data());
+                state.functions[i] = text.str();
+                if (state.remaining.fetch_sub(1) == 1) {
+                    write_unit(state);
+                }
+            });
+        }
+    }
+    scheduler.run();
+    
+    logger->info("PPC decompile finished");
+}
+
+void decompile(const std::string& file_in, const std::string& file_out, int start, int end) {
+    MappedFile file(file_in);
+    ByteSpan bytes = file.bytes();
+    
+    if (end == -1) {
+        end = (int)bytes.size;
+    }
+    
+    decompile(bytes.subspan((ulong)start, (ulong)(end - start)), file_out, (ulong)start);
+}
+
 }
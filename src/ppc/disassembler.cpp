@@ -1,11 +1,14 @@
 
-#include <cmath>
+#include <algorithm>
 #include <fstream>
-#include <at_utils>
 #include <at_logging>
 
 #include "types.h"
-#include "ppc/instruction.h"
+#include "parallel.h"
+#include "ppc/decoder.h"
+#include "ppc/batch.h"
+#include "ppc/code_section.h"
+#include "ppc/listing.h"
 #include "ppc/symbol.h"
 #include "ppc/disassembler.h"
 
@@ -15,58 +18,95 @@ using std::ios;
 
 static logging::Logger* logger = logging::get_logger("ppc.dis");
 
-void disassemble(const std::string& file_in, const std::string& file_out, int start, int end, bool info) {
+void disassemble(CodeSection& section, const std::string& file_out, bool info, uint jobs) {
     logger->info("Disassembling PPC");
     
-    std::fstream input(file_in, ios::in | ios::binary);
     std::fstream output(file_out, ios::out);
+    ListingWriter writer(output);
+    writer.set_address_width(section.bytes().size);
     
-    uint position;
+    const ulong base = section.get_base();
+    const std::vector<Symbol>& symbs = section.get_symbols();
+    const SymbolIndex& names = section.get_symbol_index();
+    writer.set_names(&names);
     
-    if (end == -1) {
-        input.seekg(0, ios::end);
-        end = (int)input.tellg();
+    if (jobs == 1) {
+        for (const auto& symbol : symbs) {
+            logger->debug(std::string(symbol.name));
+            writer.write_symbol(symbol, base, info);
+        }
+    } else {
+        // Functions are formatted into their own buffers a window at a time, then written in order,
+        // so the output matches the serial path exactly without holding the whole listing in memory
+        if (jobs == 0) {
+            jobs = hardware_jobs();
+        }
+        const std::size_t window = (std::size_t)jobs * 64;
+        std::vector<ListingWriter> buffers(window);
+        for (auto& buffer : buffers) {
+            buffer.set_address_width(section.bytes().size);
+            buffer.set_names(&names);
+        }
+        
+        for (std::size_t first = 0; first < symbs.size(); first += window) {
+            const std::size_t count = std::min(window, symbs.size() - first);
+            parallel_for(count, jobs, [&](std::size_t i) {
+                buffers[i].clear();
+                buffers[i].write_symbol(symbs[first + i], base, info);
+            });
+            for (std::size_t i = 0; i < count; ++i) {
+                logger->debug(std::string(symbs[first + i].name));
+                writer.write(buffers[i].contents());
+            }
+        }
     }
     
-    const int size = end - start;
-    const int hex_length = (int)std::floor((std::log(size) / std::log(16)) + 1) + 2;
-    uchar instruction[4];
+    writer.flush();
+    output.close();
     
-    // New style
-    std::vector<Symbol> symbs = generate_symbols(file_in, start, end);
-    for (const auto& symbol : symbs) {
-        logger->debug(symbol.name);
-        
-        output << "; function: " << symbol.name << " at " << util::ltoh(symbol.start) << "\n";
+    logger->info("PPC disassembly finished");
+}
+
+void disassemble_stream(ByteSpan code, std::ostream& output, ulong base, bool info) {
+    // Bytes decoded per step, only this much, the current function and a bit per word are held at once
+    constexpr std::size_t CHUNK_SIZE = 1u << 14;
+    
+    ListingWriter writer(output);
+    writer.set_address_width(code.size);
+    
+    // Call targets need the whole section, so take them in a sweep ahead of the listing
+    CallTargets targets = find_call_targets(code);
+    SymbolSplitter splitter(base, &targets);
+    Symbol symbol = Symbol(0, 0, "");
+    DecodedBlock block;
+    
+    for (std::size_t offset = 0; offset < code.size; offset += CHUNK_SIZE) {
+        ByteSpan chunk = code.subspan(offset, CHUNK_SIZE);
+        decode_range(chunk.data, chunk.size, block);
         
-        input.seekg(symbol.start);
-        while (input.tellg() <= (std::streamoff)symbol.end) {
-            position = (ulong)input.tellg() - start;
-            
-            input.read((char*)instruction, 4);
-            
-            Instruction* instruct = create_instruction(instruction);
-            
-            std::string hex = util::itoh(position);
-            std::string padding(hex_length - hex.length(), ' ');
-            
-            if (info) {
-                output << padding << hex << "    ";
-                output << util::ctoh(instruction[0], false, true) << " " << util::ctoh(instruction[1], false, true)
-                       << " "
-                       << util::ctoh(instruction[2], false, true) << " " << util::ctoh(instruction[3], false, true)
-                       << "    ";
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            if (splitter.push(block.get(i), symbol)) {
+                writer.write_symbol(symbol, base, info);
+                writer.flush();
             }
-            output << instruct->code_name() << " " << instruct->get_variables() << "\n";
-            
-            delete instruct;
         }
     }
+}
+
+void disassemble(ByteSpan code, const std::string& file_out, ulong base, bool info, uint jobs) {
+    CodeSection section(code, base);
+    disassemble(section, file_out, info, jobs);
+}
+
+void disassemble(const std::string& file_in, const std::string& file_out, int start, int end, bool info, uint jobs) {
+    MappedFile file(file_in);
+    ByteSpan bytes = file.bytes();
     
-    input.close();
-    output.close();
+    if (end == -1) {
+        end = (int)bytes.size;
+    }
     
-    logger->info("PPC disassembly finished");
+    disassemble(bytes.subspan((ulong)start, (ulong)(end - start)), file_out, (ulong)start, info, jobs);
 }
 
 }
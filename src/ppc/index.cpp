@@ -0,0 +1,168 @@
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <at_logging>
+
+#include "ppc/decode_cache.h"
+#include "ppc/index.h"
+
+namespace PPC {
+
+static logging::Logger *logger = logging::get_logger("ppc.index");
+
+static const char INDEX_MAGIC[4] = {'G', 'C', 'D', 'I'};
+
+static std::size_t align(std::size_t size) {
+    return (size + 3) & ~(std::size_t)3;
+}
+
+template<typename T>
+static void write_table(std::ofstream& output, const std::vector<T>& table) {
+    output.write((const char*)table.data(), (std::streamsize)(table.size() * sizeof(T)));
+}
+
+static void write_pool(std::ofstream& output, const std::string& pool) {
+    static const char padding[4] = {};
+    output.write(pool.data(), (std::streamsize)pool.size());
+    output.write(padding, (std::streamsize)(align(pool.size()) - pool.size()));
+}
+
+void write_index(CodeSection& section, const std::string& output) {
+    InstructionSpan decoded = section.get_instructions();
+    const std::vector<Symbol>& symbols = section.get_symbols();
+    
+    std::vector<IndexFunction> functions;
+    functions.reserve(symbols.size());
+    std::string names;
+    for (const auto& symbol : symbols) {
+        IndexFunction function {};
+        function.start = (uint)symbol.start;
+        function.end = (uint)(symbol.start + symbol.instructions.size() * 4);
+        function.name = (uint)names.size();
+        function.name_length = (uint)symbol.name.size();
+        names += symbol.name;
+        functions.push_back(function);
+    }
+    
+    std::vector<IndexInstruction> instructions;
+    instructions.reserve(decoded.size());
+    std::string text;
+    for (const auto& inst : decoded) {
+        const CachedInstruction& cached = decode_cached(inst);
+        IndexInstruction record {};
+        record.word = inst.word;
+        record.operands = (uint)text.size();
+        record.mnemonic = (ushort)inst.mnemonic;
+        record.suffix = inst.suffix;
+        record.operand_length = cached.operand_length;
+        text.append(cached.operands, cached.operand_length);
+        instructions.push_back(record);
+    }
+    
+    IndexHeader header {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.base = (uint)section.get_base();
+    header.function_count = (uint)functions.size();
+    header.instruction_count = (uint)instructions.size();
+    header.names_size = (uint)names.size();
+    header.text_size = (uint)text.size();
+    
+    std::ofstream out(output, std::ios::out | std::ios::binary);
+    out.write((const char*)&header, sizeof(header));
+    write_table(out, functions);
+    write_table(out, instructions);
+    write_pool(out, names);
+    write_pool(out, text);
+    
+    logger->debug("Wrote index " + output);
+}
+
+SectionIndex::SectionIndex(const std::string& filename) : file(filename) {
+    this->header = nullptr;
+    this->functions = nullptr;
+    this->instructions = nullptr;
+    this->names = nullptr;
+    this->text = nullptr;
+    
+    ByteSpan bytes = this->file.bytes();
+    if (bytes.size < sizeof(IndexHeader)) {
+        return;
+    }
+    const IndexHeader *head = (const IndexHeader*)bytes.data;
+    if (std::memcmp(head->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || head->version != INDEX_VERSION) {
+        return;
+    }
+    
+    const std::size_t functions_at = sizeof(IndexHeader);
+    const std::size_t instructions_at = functions_at + (std::size_t)head->function_count * sizeof(IndexFunction);
+    const std::size_t names_at = instructions_at + (std::size_t)head->instruction_count * sizeof(IndexInstruction);
+    const std::size_t text_at = names_at + align(head->names_size);
+    if (text_at + head->text_size > bytes.size) {
+        logger->warn("Index " + filename + " is truncated");
+        return;
+    }
+    
+    this->header = head;
+    this->functions = (const IndexFunction*)(bytes.data + functions_at);
+    this->instructions = (const IndexInstruction*)(bytes.data + instructions_at);
+    this->names = (const char*)(bytes.data + names_at);
+    this->text = (const char*)(bytes.data + text_at);
+}
+
+bool SectionIndex::is_valid() const {
+    return this->header != nullptr;
+}
+
+ulong SectionIndex::get_base() const {
+    return this->header->base;
+}
+
+ulong SectionIndex::function_count() const {
+    return this->header->function_count;
+}
+
+ulong SectionIndex::instruction_count() const {
+    return this->header->instruction_count;
+}
+
+const IndexFunction *SectionIndex::find_function(ulong address) const {
+    const IndexFunction *begin = this->functions, *end = this->functions + this->header->function_count;
+    const IndexFunction *after = std::upper_bound(begin, end, address, [](ulong value, const IndexFunction& func) {
+        return value < func.start;
+    });
+    if (after == begin || address >= (after - 1)->end) {
+        return nullptr;
+    }
+    return after - 1;
+}
+
+const IndexInstruction *SectionIndex::find_instruction(ulong address) const {
+    const ulong base = this->header->base;
+    if (address < base || address % 4 != base % 4 || (address - base) / 4 >= this->header->instruction_count) {
+        return nullptr;
+    }
+    return this->instructions + (address - base) / 4;
+}
+
+std::string_view SectionIndex::name(const IndexFunction& function) const {
+    return std::string_view(this->names + function.name, function.name_length);
+}
+
+std::string SectionIndex::code_name(const IndexInstruction& instruction) const {
+    DecodedInstruction inst {};
+    if (instruction.mnemonic < (ushort)Mnemonic::COUNT) {
+        inst.mnemonic = (Mnemonic)instruction.mnemonic;
+    } else {
+        inst.mnemonic = Mnemonic::UNKNOWN_INSTRUCTION;
+    }
+    inst.suffix = instruction.suffix;
+    return PPC::code_name(inst);
+}
+
+std::string_view SectionIndex::operands(const IndexInstruction& instruction) const {
+    return std::string_view(this->text + instruction.operands, instruction.operand_length);
+}
+
+}
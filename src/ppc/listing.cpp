@@ -0,0 +1,167 @@
+
+#include <algorithm>
+
+#include "ppc/listing.h"
+#include "ppc/decode_cache.h"
+
+namespace PPC {
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// Longest line write_line can produce, not counting the operands
+static constexpr std::size_t MAX_LINE = 2 + 16 + 4 + 4 * 3 + 4 + MAX_CODE_NAME + 1 + 1;
+
+static uint hex_length(ulong value) {
+    uint out = 1;
+    while (value >>= 4) {
+        out++;
+    }
+    return out;
+}
+
+// 0x followed by the digits of value, no padding
+static char *write_hex(char *out, ulong value) {
+    const uint length = hex_length(value);
+    *out++ = '0';
+    *out++ = 'x';
+    for (uint i = length; i > 0; --i) {
+        out[i - 1] = hex_digits[value & 0xF];
+        value >>= 4;
+    }
+    return out + length;
+}
+
+static char *write_byte(char *out, uchar value) {
+    *out++ = hex_digits[value >> 4];
+    *out++ = hex_digits[value & 0xF];
+    return out;
+}
+
+static char *write_text(char *out, std::string_view text) {
+    return out + text.copy(out, text.length());
+}
+
+ListingWriter::ListingWriter() {
+    this->output = nullptr;
+    this->used = 0;
+    this->address_width = 3;
+    this->names = nullptr;
+}
+
+ListingWriter::ListingWriter(std::ostream& output) : ListingWriter() {
+    this->output = &output;
+    this->buffer.resize(BLOCK_SIZE);
+}
+
+ListingWriter::~ListingWriter() {
+    if (this->output != nullptr) {
+        this->flush();
+    }
+}
+
+char *ListingWriter::reserve(std::size_t length) {
+    if (this->used + length > this->buffer.size()) {
+        if (this->output != nullptr) {
+            this->flush();
+        }
+        if (this->used + length > this->buffer.size()) {
+            this->buffer.resize(std::max(this->buffer.size() * 2, this->used + length));
+        }
+    }
+    return this->buffer.data() + this->used;
+}
+
+void ListingWriter::set_address_width(ulong size) {
+    this->address_width = 2 + hex_length(size);
+}
+
+void ListingWriter::set_names(const SymbolIndex *names) {
+    this->names = names;
+}
+
+std::string_view ListingWriter::operands(const DecodedInstruction& inst, ulong address) const {
+    if (this->names != nullptr && inst.mnemonic == Mnemonic::B && !(inst.suffix & DecodedInstruction::ABSOLUTE)) {
+        const SymbolIndex::Entry *target = this->names->at((ulong)((long)address + inst.branch_offset()));
+        if (target != nullptr) {
+            return target->name;
+        }
+    }
+    const CachedInstruction& cached = decode_cached(inst);
+    return std::string_view(cached.operands, cached.operand_length);
+}
+
+void ListingWriter::write_symbol(const Symbol& symbol, ulong base, bool info) {
+    this->write_header(symbol);
+
+    ulong address = symbol.start;
+    for (const auto& inst : symbol.instructions) {
+        this->write_line(inst, address - base, info, this->operands(inst, address));
+        address += 4;
+    }
+}
+
+void ListingWriter::write_header(const Symbol& symbol) {
+    char *start = this->reserve(symbol.name.length() + 32);
+    char *pos = write_text(start, "; function: ");
+    pos = write_text(pos, symbol.name);
+    pos = write_text(pos, " at ");
+    pos = write_hex(pos, symbol.start);
+    *pos++ = '\n';
+    this->used += pos - start;
+}
+
+void ListingWriter::write_instruction(const DecodedInstruction& inst, ulong position, bool info) {
+    const CachedInstruction& cached = decode_cached(inst);
+    this->write_line(inst, position, info, std::string_view(cached.operands, cached.operand_length));
+}
+
+void ListingWriter::write_line(const DecodedInstruction& inst, ulong position, bool info, std::string_view operands) {
+    char *start = this->reserve(MAX_LINE + operands.length());
+    char *pos = start;
+
+    if (info) {
+        const uint width = 2 + hex_length(position);
+        for (uint i = width; i < this->address_width; ++i) {
+            *pos++ = ' ';
+        }
+        pos = write_hex(pos, position);
+        pos = write_text(pos, "    ");
+        pos = write_byte(pos, (uchar)(inst.word >> 24));
+        *pos++ = ' ';
+        pos = write_byte(pos, (uchar)(inst.word >> 16));
+        *pos++ = ' ';
+        pos = write_byte(pos, (uchar)(inst.word >> 8));
+        *pos++ = ' ';
+        pos = write_byte(pos, (uchar)inst.word);
+        pos = write_text(pos, "    ");
+    }
+
+    pos += format_code_name(inst, pos);
+    *pos++ = ' ';
+    pos = write_text(pos, operands);
+    *pos++ = '\n';
+
+    this->used += pos - start;
+}
+
+void ListingWriter::write(std::string_view text) {
+    char *start = this->reserve(text.length());
+    this->used += write_text(start, text) - start;
+}
+
+std::string_view ListingWriter::contents() const {
+    return std::string_view(this->buffer.data(), this->used);
+}
+
+void ListingWriter::clear() {
+    this->used = 0;
+}
+
+void ListingWriter::flush() {
+    if (this->output != nullptr && this->used > 0) {
+        this->output->write(this->buffer.data(), this->used);
+    }
+    this->used = 0;
+}
+
+}
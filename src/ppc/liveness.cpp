@@ -0,0 +1,123 @@
+
+#include "ppc/liveness.h"
+#include "ppc/register.h"
+
+namespace PPC {
+
+void LivenessAnalyzer::summarize(InstructionSpan instructions, uint block, const FunctionRegisters *calls,
+                                 std::size_t& next_call) {
+    const ControlFlowGraph::Block& range = this->graph[block];
+    BlockState& state = this->states[block];
+    for (uint i = range.first; i <= range.last; ++i) {
+        const DecodedInstruction& inst = instructions[i];
+        const RegisterMasks masks = register_masks(inst);
+
+        state.gpr_use |= masks.gpr_read & ~state.gpr_def;
+        state.fpr_use |= masks.fpr_read & ~state.fpr_def;
+        state.gpr_def |= masks.gpr_write;
+        state.fpr_def |= masks.fpr_write;
+        state.gpr_gen |= masks.gpr_write;
+        state.fpr_gen |= masks.fpr_write;
+        state.gpr_kill |= masks.gpr_write;
+        state.fpr_kill |= masks.fpr_write;
+
+        if (branch_flow(inst, i, instructions.size()).calls) {
+            const FunctionRegisters& callee = calls != nullptr ? calls[next_call++] : UNKNOWN_CALL;
+            state.gpr_use |= callee.gpr_in & ~state.gpr_def;
+            state.fpr_use |= callee.fpr_in & ~state.fpr_def;
+            // Whatever the callee does, the caller can't count on a volatile register coming back
+            state.gpr_def |= VOLATILE_GPRS;
+            state.fpr_def |= VOLATILE_FPRS;
+            state.gpr_gen = (state.gpr_gen & ~callee.gpr_clobber) | callee.gpr_out;
+            state.fpr_gen = (state.fpr_gen & ~callee.fpr_clobber) | callee.fpr_out;
+            state.gpr_kill |= callee.gpr_clobber;
+            state.fpr_kill |= callee.fpr_clobber;
+        }
+    }
+}
+
+FunctionRegisters LivenessAnalyzer::analyze(InstructionSpan instructions, const FunctionRegisters *calls) {
+    FunctionRegisters out {};
+    this->gpr_entry = this->fpr_entry = 0;
+    if (instructions.empty()) {
+        return out;
+    }
+
+    this->graph.build(instructions);
+    this->states.assign(this->graph.size(), BlockState {});
+    std::size_t next_call = 0;
+    for (uint b = 0; b < this->graph.size(); ++b) {
+        this->summarize(instructions, b, calls, next_call);
+    }
+    // Unreachable blocks can't change what the entry needs or what reaches an exit
+    const EdgeSpan order = this->graph.reverse_postorder();
+
+    // Live registers flow backwards, so postorder sees most successors first
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = order.size(); i > 0; --i) {
+            BlockState& state = this->states[order[i - 1]];
+            uint gpr_out = 0, fpr_out = 0;
+            for (uint next : this->graph.successors(order[i - 1])) {
+                gpr_out |= this->states[next].gpr_live;
+                fpr_out |= this->states[next].fpr_live;
+            }
+            const uint gpr_live = state.gpr_use | (gpr_out & ~state.gpr_def);
+            const uint fpr_live = state.fpr_use | (fpr_out & ~state.fpr_def);
+            if (gpr_live != state.gpr_live || fpr_live != state.fpr_live) {
+                state.gpr_live = gpr_live;
+                state.fpr_live = fpr_live;
+                changed = true;
+            }
+        }
+    }
+
+    // Writes flow forwards to the exits, a return register set on some path is taken as the result
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (uint block : order) {
+            const BlockState& state = this->states[block];
+            const uint gpr_reach = (state.gpr_reach & ~state.gpr_kill) | state.gpr_gen;
+            const uint fpr_reach = (state.fpr_reach & ~state.fpr_kill) | state.fpr_gen;
+            for (uint next : this->graph.successors(block)) {
+                BlockState& after = this->states[next];
+                if ((after.gpr_reach | gpr_reach) != after.gpr_reach || (after.fpr_reach | fpr_reach) != after.fpr_reach) {
+                    after.gpr_reach |= gpr_reach;
+                    after.fpr_reach |= fpr_reach;
+                    changed = true;
+                }
+            }
+            if (this->graph[block].exits) {
+                out.gpr_out |= gpr_reach & RETURN_GPRS;
+                out.fpr_out |= fpr_reach & RETURN_FPRS;
+            }
+        }
+    }
+
+    this->gpr_entry = this->states[0].gpr_live;
+    this->fpr_entry = this->states[0].fpr_live;
+    out.gpr_in = this->gpr_entry & ARGUMENT_GPRS;
+    out.fpr_in = this->fpr_entry & ARGUMENT_FPRS;
+    for (uint block : order) {
+        out.gpr_clobber |= this->states[block].gpr_kill & VOLATILE_GPRS;
+        out.fpr_clobber |= this->states[block].fpr_kill & VOLATILE_FPRS;
+    }
+    return out;
+}
+
+uint LivenessAnalyzer::entry_gprs() const {
+    return this->gpr_entry;
+}
+
+uint LivenessAnalyzer::entry_fprs() const {
+    return this->fpr_entry;
+}
+
+FunctionRegisters analyze_liveness(InstructionSpan instructions) {
+    LivenessAnalyzer analyzer;
+    return analyzer.analyze(instructions);
+}
+
+}
@@ -0,0 +1,236 @@
+
+#include <unordered_map>
+#include <at_logging>
+
+#include "ppc/codes.h"
+#include "ppc/operands.h"
+
+namespace PPC {
+
+static logging::Logger* logger = logging::get_logger("ppc.operands");
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static uint parse_number(std::string_view text, std::size_t& pos) {
+    uint out = 0;
+    while (pos < text.length() && text[pos] >= '0' && text[pos] <= '9') {
+        out = out * 10 + (text[pos++] - '0');
+    }
+    return out;
+}
+
+static void add_op(OperandProgram& program, const OperandOp& op) {
+    if (program.num_ops == OperandProgram::MAX_OPS) {
+        logger->error("Operand pattern has too many parts");
+        return;
+    }
+    program.ops[program.num_ops++] = op;
+}
+
+static void add_literal(OperandProgram& program, std::string_view text) {
+    if (text.empty()) {
+        return;
+    } else if (program.text_length + text.length() > OperandProgram::MAX_TEXT) {
+        logger->error("Operand pattern literal text too long");
+        return;
+    }
+    OperandOp op {OperandOp::LITERAL, OperandOp::NONE, program.text_length, (uchar)text.length()};
+    for (auto ch : text) {
+        program.text[program.text_length++] = ch;
+    }
+    add_op(program, op);
+}
+
+static bool ends_with(std::string_view text, std::string_view suffix) {
+    return text.length() >= suffix.length() && text.substr(text.length() - suffix.length()) == suffix;
+}
+
+static void add_register(OperandProgram& program, std::string_view prefix, const OperandOp& op) {
+    RegisterOperand reg {RegisterOperand::GPR, op.start, op.end};
+    if (ends_with(prefix, "crf")) {
+        reg.kind = RegisterOperand::CR_FIELD;
+    } else if (ends_with(prefix, "crb")) {
+        reg.kind = RegisterOperand::CR_BIT;
+    } else if (ends_with(prefix, "fr")) {
+        reg.kind = RegisterOperand::FPR;
+    } else if (!ends_with(prefix, "r")) {
+        return;
+    }
+    if (program.num_registers == OperandProgram::MAX_REGISTERS) {
+        logger->error("Operand pattern has too many registers");
+        return;
+    }
+    program.registers[program.num_registers++] = reg;
+}
+
+OperandProgram compile_pattern(std::string_view pattern) {
+    OperandProgram out {};
+
+    std::size_t pos = 0;
+    std::string_view prefix;
+    while (pos < pattern.length()) {
+        std::size_t open = pattern.find('{', pos);
+        if (open == std::string_view::npos) {
+            add_literal(out, pattern.substr(pos));
+            break;
+        }
+        prefix = pattern.substr(pos, open - pos);
+        add_literal(out, prefix);
+
+        std::size_t close = pattern.find('}', open);
+        if (close == std::string_view::npos) {
+            logger->error("Unterminated operand field in pattern");
+            break;
+        }
+        std::string_view field = pattern.substr(open + 1, close - open - 1);
+        pos = close + 1;
+
+        if (field == "spr") {
+            add_op(out, OperandOp {OperandOp::SPR, OperandOp::NONE, 0, 0});
+            continue;
+        }
+
+        // Fields are b0:[s][a][X]start,end, an empty range emits nothing
+        std::size_t spec = field.find(':') + 1;
+        if (spec >= field.length()) {
+            continue;
+        }
+        OperandOp op {OperandOp::FIELD, OperandOp::NONE, 0, 0};
+        for (; spec < field.length() && (field[spec] < '0' || field[spec] > '9'); ++spec) {
+            if (field[spec] == 's') {
+                op.flags |= OperandOp::SIGNED;
+            } else if (field[spec] == 'a') {
+                op.flags |= OperandOp::SIGNED | OperandOp::ABSOLUTE;
+            } else if (field[spec] == 'X') {
+                op.flags |= OperandOp::HEX;
+            }
+        }
+        op.start = (uchar)parse_number(field, spec);
+        ++spec;
+        op.end = (uchar)parse_number(field, spec);
+        add_op(out, op);
+        if (!(op.flags & OperandOp::HEX)) {
+            add_register(out, prefix, op);
+        }
+    }
+
+    return out;
+}
+
+// Keyed by the text itself, the same pattern can sit at a different address in each translation unit
+using ProgramMap = std::unordered_map<std::string_view, OperandProgram>;
+
+static void register_pattern(ProgramMap& programs, std::string_view pattern) {
+    if (!pattern.empty() && programs.count(pattern) == 0) {
+        programs.emplace(pattern, compile_pattern(pattern));
+    }
+}
+
+template<std::size_t N>
+static void register_table(ProgramMap& programs, const CodeTable<N>& table) {
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        register_pattern(programs, table[i]);
+    }
+}
+
+static ProgramMap compile_all() {
+    ProgramMap out;
+
+    register_table(out, primary_patterns);
+    register_table(out, secondary_patterns_ps);
+    register_table(out, secondary_patterns_sb);
+    register_table(out, secondary_patterns_math);
+    register_table(out, secondary_patterns_float);
+    register_table(out, secondary_patterns_double);
+
+    for (auto pattern : {pattern_none, pattern_unknown, pattern_cmp_imm_word, pattern_cmp_imm, pattern_cmp_word,
+                         pattern_cmp, pattern_add_imm, pattern_sub_imm, pattern_branch_cond, pattern_branch_reg,
+                         pattern_move, pattern_single, pattern_mtcrf, pattern_from_spr, pattern_to_spr}) {
+        register_pattern(out, pattern);
+    }
+
+    return out;
+}
+
+const OperandProgram& get_program(std::string_view pattern) {
+    // Every pattern the decoder can return lives in codes.h, so they are all compiled up front. The
+    // views in the map point at those constants, which live as long as the program. Anything else is
+    // compiled per call.
+    static const ProgramMap programs = compile_all();
+    static thread_local OperandProgram fallback;
+
+    auto found = programs.find(pattern);
+    if (found != programs.end()) {
+        return found->second;
+    }
+    fallback = compile_pattern(pattern);
+    return fallback;
+}
+
+static char* write_decimal(char *out, ulong value) {
+    char digits[20];
+    uint count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+static char* write_hex(char *out, ulong value) {
+    *out++ = '0';
+    *out++ = 'x';
+    int shift = 28;
+    while (shift > 0 && ((value >> shift) & 0xF) == 0) {
+        shift -= 4;
+    }
+    for (; shift >= 0; shift -= 4) {
+        *out++ = hex_digits[(value >> shift) & 0xF];
+    }
+    return out;
+}
+
+std::size_t format_operands(const OperandProgram& program, uint word, char *out) {
+    char *pos = out;
+    for (uint i = 0; i < program.num_ops; ++i) {
+        const OperandOp& op = program.ops[i];
+        switch (op.kind) {
+            case OperandOp::LITERAL:
+                for (uint j = 0; j < op.end; ++j) {
+                    *pos++ = program.text[op.start + j];
+                }
+                break;
+            case OperandOp::SPR:
+                pos = write_decimal(pos, get_bits(word, 11, 15) + (get_bits(word, 16, 20) << 5));
+                break;
+            case OperandOp::FIELD: {
+                ulong value = get_bits(word, op.start, op.end);
+                if (op.flags & OperandOp::SIGNED) {
+                    const uint width = op.end - op.start + 1u;
+                    if (value >> (width - 1)) {
+                        value = (1ul << width) - value;
+                        if (!(op.flags & OperandOp::ABSOLUTE)) {
+                            *pos++ = '-';
+                        }
+                    }
+                }
+                if (op.flags & OperandOp::HEX) {
+                    pos = write_hex(pos, value);
+                } else {
+                    pos = write_decimal(pos, value);
+                }
+                break;
+            }
+        }
+    }
+    return pos - out;
+}
+
+std::size_t format_operands(const DecodedInstruction& inst, char *out) {
+    return format_operands(get_program(operand_pattern(inst)), inst.word, out);
+}
+
+}
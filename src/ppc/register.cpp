@@ -5,6 +5,8 @@
 
 #include "types.h"
 #include "ppc/register.h"
+#include "ppc/codes.h"
+#include "ppc/decoder.h"
 
 namespace PPC {
 
@@ -71,4 +73,86 @@ Register::RType get_type(const std::string& type) {
     }
 }
 
-}
\ No newline at end of file
+RegisterMasks register_masks(const DecodedInstruction& inst) {
+    RegisterMasks out {};
+    const uint roles = register_roles(inst);
+    const uint word = inst.word;
+    
+    if (roles & D_READ) {
+        out.gpr_read |= 1u << inst.rd;
+    }
+    if (roles & D_WRITE) {
+        out.gpr_write |= 1u << inst.rd;
+    }
+    if (roles & D_READ_FLOAT) {
+        out.fpr_read |= 1u << inst.rd;
+    }
+    if (roles & D_WRITE_FLOAT) {
+        out.fpr_write |= 1u << inst.rd;
+    }
+    if ((roles & A_READ) || ((roles & A_BASE) && inst.ra != 0)) {
+        out.gpr_read |= 1u << inst.ra;
+    }
+    if (roles & A_WRITE) {
+        out.gpr_write |= 1u << inst.ra;
+    }
+    if (roles & A_READ_FLOAT) {
+        out.fpr_read |= 1u << inst.ra;
+    }
+    if (roles & B_READ) {
+        out.gpr_read |= 1u << inst.rb;
+    }
+    if (roles & B_READ_FLOAT) {
+        out.fpr_read |= 1u << inst.rb;
+    }
+    if (roles & C_READ_FLOAT) {
+        out.fpr_read |= 1u << inst.rc;
+    }
+    
+    if (roles & D_WRITE_FIELD) {
+        out.cr_write |= 1u << (inst.rd >> 2);
+    }
+    if (roles & A_READ_FIELD) {
+        out.cr_read |= 1u << (inst.ra >> 2);
+    }
+    if (roles & D_WRITE_BIT) {
+        out.cr_write |= 1u << (inst.rd >> 2);
+    }
+    if (roles & AB_READ_BITS) {
+        out.cr_read |= (1u << (inst.ra >> 2)) | (1u << (inst.rb >> 2));
+    }
+    // BO with 0x10 set branches whatever the condition
+    if ((roles & READ_BI) && !(inst.rd & 0x10)) {
+        out.cr_read |= 1u << (inst.ra >> 2);
+    }
+    // Floating point and paired single codes record into cr1
+    if ((roles & RECORD) && get_bit(word, 31)) {
+        const bool floating = inst.opcode == 4 || inst.opcode == 59 || inst.opcode == 63;
+        out.cr_write |= floating ? 2u : 1u;
+    }
+    if (roles & WRITE_CR0) {
+        out.cr_write |= 1u;
+    }
+    if (roles & READ_CR) {
+        out.cr_read |= 0xFFu;
+    }
+    if (roles & WRITE_CRM) {
+        for (uint field = 0; field < 8; ++field) {
+            if (get_bit(word, 12 + field)) {
+                out.cr_write |= 1u << field;
+            }
+        }
+    }
+    
+    const uint multiple = ~0u << inst.rd;
+    if (roles & WRITE_MULTIPLE) {
+        out.gpr_write |= multiple;
+    }
+    if (roles & READ_MULTIPLE) {
+        out.gpr_read |= multiple;
+    }
+    
+    return out;
+}
+
+}
@@ -0,0 +1,721 @@
+
+#include <algorithm>
+
+#include "ppc/ssa.h"
+#include "ppc/register.h"
+
+namespace PPC {
+
+/**
+ * A set of SSA variables, one mask per kind. CR holds a bit per field
+ */
+struct VariableMask {
+    uint gpr, fpr, cr;
+
+    bool any() const {
+        return gpr || fpr || cr;
+    }
+    bool operator!=(const VariableMask& other) const {
+        return gpr != other.gpr || fpr != other.fpr || cr != other.cr;
+    }
+    VariableMask operator|(const VariableMask& other) const {
+        return VariableMask {gpr | other.gpr, fpr | other.fpr, cr | other.cr};
+    }
+    VariableMask operator&(const VariableMask& other) const {
+        return VariableMask {gpr & other.gpr, fpr & other.fpr, cr & other.cr};
+    }
+    VariableMask operator~() const {
+        return VariableMask {~gpr, ~fpr, ~cr & 0xFFu};
+    }
+};
+
+// Call clobbered CR fields, cr0, cr1 and cr5-cr7
+static constexpr uint VOLATILE_CRS = 0xE3u;
+static constexpr uint NUM_ARGUMENTS = 16;
+// What a return hands back, r3 and fr1
+static constexpr VariableMask RETURN_VARIABLES = {1u << 3, 1u << 1, 0};
+
+static ValueType variable_type(uint variable) {
+    if (variable < FPR_VARIABLE) {
+        return ValueType::INT;
+    } else if (variable < CR_VARIABLE) {
+        return ValueType::FLOAT;
+    }
+    return ValueType::CONDITION;
+}
+
+// Call f(variable) for each variable in mask, lowest first
+template<typename F>
+static void for_each_variable(const VariableMask& mask, F f) {
+    for (uint r = 0; r < 32; ++r) {
+        if (mask.gpr & (1u << r)) {
+            f(r);
+        }
+    }
+    for (uint r = 0; r < 32; ++r) {
+        if (mask.fpr & (1u << r)) {
+            f(FPR_VARIABLE + r);
+        }
+    }
+    for (uint r = 0; r < 8; ++r) {
+        if (mask.cr & (1u << r)) {
+            f(CR_VARIABLE + r);
+        }
+    }
+}
+
+static bool is_branch(const DecodedInstruction& inst) {
+    return inst.opcode == 16 || inst.opcode == 18 ||
+           (inst.opcode == 19 && (inst.xo == 16 || inst.xo == 528 || inst.xo == 50));
+}
+
+// A b out of the function, or a bc that's always taken out of it
+static bool is_tail_call(const DecodedInstruction& inst, const BranchFlow& flow) {
+    return (inst.opcode == 18 || inst.opcode == 16) && !flow.calls && !flow.next && flow.exits;
+}
+
+static bool is_update(const DecodedInstruction& inst) {
+    switch (inst.opcode) {
+        case 33: case 35: case 37: case 39: case 41: case 43: case 45:
+        case 49: case 51: case 53: case 55:
+            return true;
+        case 31:
+            switch (inst.xo) {
+                case 55: case 119: case 183: case 247: case 311: case 375: case 439:
+                case 567: case 631: case 695: case 759:
+                    return true;
+            }
+    }
+    return false;
+}
+
+static bool is_record(const DecodedInstruction& inst) {
+    return (inst.suffix & DecodedInstruction::RECORD) || inst.opcode == 13 || inst.opcode == 28 ||
+           inst.opcode == 29;
+}
+
+// Everything the lifter has an instruction read and write. Calls also read the argument registers and
+// clobber the volatile ones
+static void effects_of(const DecodedInstruction& inst, const BranchFlow& flow, VariableMask& reads, VariableMask& writes) {
+    const RegisterMasks masks = register_masks(inst);
+    reads = VariableMask {masks.gpr_read, masks.fpr_read, masks.cr_read};
+    writes = VariableMask {masks.gpr_write, masks.fpr_write, masks.cr_write};
+    if (flow.calls || is_tail_call(inst, flow)) {
+        reads.gpr |= ARGUMENT_GPRS;
+        reads.fpr |= ARGUMENT_FPRS;
+        writes.gpr |= VOLATILE_GPRS;
+        writes.fpr |= VOLATILE_FPRS;
+        writes.cr |= VOLATILE_CRS;
+    }
+}
+
+/**
+ * The shape of a load or store, D-form or non-updating X-form
+ */
+struct MemoryForm {
+    uchar width;
+    ValueType type;
+    bool store, sign;
+};
+
+static bool memory_form(const DecodedInstruction& inst, MemoryForm& out) {
+    uint opcode = inst.opcode;
+    if (opcode == 31) {
+        // The X-forms line up with the D-form opcodes
+        switch (inst.xo) {
+            case 23: opcode = 32; break;
+            case 87: opcode = 34; break;
+            case 151: opcode = 36; break;
+            case 215: opcode = 38; break;
+            case 279: opcode = 40; break;
+            case 343: opcode = 42; break;
+            case 407: opcode = 44; break;
+            case 535: opcode = 48; break;
+            case 599: opcode = 50; break;
+            case 663: opcode = 52; break;
+            case 727: opcode = 54; break;
+            default: return false;
+        }
+    } else if (opcode < 32 || opcode > 55 || opcode == 46 || opcode == 47) {
+        return false;
+    }
+
+    switch (opcode & ~1u) {
+        case 32: out = MemoryForm {4, ValueType::INT, false, false}; break;
+        case 34: out = MemoryForm {1, ValueType::INT, false, false}; break;
+        case 36: out = MemoryForm {4, ValueType::INT, true, false}; break;
+        case 38: out = MemoryForm {1, ValueType::INT, true, false}; break;
+        case 40: out = MemoryForm {2, ValueType::INT, false, false}; break;
+        case 42: out = MemoryForm {2, ValueType::INT, false, true}; break;
+        case 44: out = MemoryForm {2, ValueType::INT, true, false}; break;
+        case 48: out = MemoryForm {4, ValueType::FLOAT, false, false}; break;
+        case 50: out = MemoryForm {8, ValueType::FLOAT, false, false}; break;
+        case 52: out = MemoryForm {4, ValueType::FLOAT, true, false}; break;
+        default: out = MemoryForm {8, ValueType::FLOAT, true, false}; break;
+    }
+    return true;
+}
+
+// Calls visit(runner, block) for every block in the dominance frontier of runner, as Cooper, Harvey
+// and Kennedy find them. The entry is also reached from the caller, so an edge back to it makes it a join
+template<typename F>
+static void for_each_frontier(const ControlFlowGraph& graph, F visit) {
+    for (uint b : graph.reverse_postorder()) {
+        const EdgeSpan prev = graph.predecessors(b);
+        if (prev.size() < 2 && !(b == 0 && !prev.empty())) {
+            continue;
+        }
+        const uint stop = b == 0 ? ControlFlowGraph::NONE : graph.immediate_dominator(b);
+        for (uint p : prev) {
+            if (!graph.reachable(p)) {
+                continue;
+            }
+            for (uint runner = p; runner != stop; runner = graph.immediate_dominator(runner)) {
+                visit(runner, b);
+                if (runner == 0) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+SSAFunction::SSAFunction() {
+    this->base = 0;
+    this->undefined = NO_VALUE;
+    this->registers = FunctionRegisters {};
+    for (auto& value : this->current) {
+        value = NO_VALUE;
+    }
+}
+
+ValueId SSAFunction::use(uint variable) const {
+    return this->current[variable];
+}
+
+void SSAFunction::define(uint variable, ValueId value) {
+    this->saved.push_back(Saved {variable, this->current[variable]});
+    this->current[variable] = value;
+}
+
+ValueId SSAFunction::make(Op op, ValueType type, uint block, uint num_operands, uint instruction) {
+    const ValueId id = (ValueId)this->values.size();
+    Value *value = this->values.extend(1);
+    value->op = op;
+    value->type = type;
+    value->block = block;
+    value->first_operand = (uint)this->operand_pool.size();
+    value->num_operands = num_operands;
+    value->instruction = instruction;
+    this->operand_pool.extend(num_operands);
+    return id;
+}
+
+ValueId SSAFunction::make_constant(int constant, uint block, uint instruction) {
+    const ValueId out = this->make(Op::CONSTANT, ValueType::INT, block, 0, instruction);
+    this->values[out].constant = constant;
+    return out;
+}
+
+void SSAFunction::set_operand(ValueId value, uint index, ValueId operand) {
+    this->operand_pool[this->values[value].first_operand + index] = operand;
+}
+
+ValueId SSAFunction::binary(Op op, ValueType type, ValueId first, ValueId second, uint block, uint instruction) {
+    const ValueId out = this->make(op, type, block, 2, instruction);
+    this->set_operand(out, 0, first);
+    this->set_operand(out, 1, second);
+    return out;
+}
+
+void SSAFunction::build(InstructionSpan instructions, ulong base, const FunctionRegisters *calls) {
+    this->arena.reset();
+    this->values = ArenaVector<Value>(this->arena, instructions.size() * 2 + 16);
+    this->operand_pool = ArenaVector<ValueId>(this->arena, instructions.size() * 2 + 16);
+    this->saved = ArenaVector<Saved>(this->arena);
+    this->blocks = ArenaVector<SSABlock>(this->arena);
+    this->instructions = instructions;
+    this->base = base;
+
+    this->graph.build(instructions);
+    this->registers = this->liveness.analyze(instructions, calls);
+    this->blocks.extend(this->graph.size());
+    if (instructions.empty()) {
+        return;
+    }
+
+    // Everything live at entry comes in as an argument value, the saved registers and stack pointer as
+    // well as the parameters. Anything else read before a write is undefined
+    this->undefined = this->make(Op::UNDEFINED, ValueType::NONE, 0, 0, NO_VALUE);
+    for (uint v = 0; v < NUM_VARIABLES; ++v) {
+        this->current[v] = this->undefined;
+    }
+    const VariableMask arguments {this->liveness.entry_gprs(), this->liveness.entry_fprs(), 0};
+    for_each_variable(arguments, [&](uint v) {
+        this->current[v] = this->make(Op::ARGUMENT, variable_type(v), 0, 0, NO_VALUE);
+        this->values[this->current[v]].variable = (uchar)v;
+    });
+
+    this->place_phis();
+    this->rename();
+}
+
+void SSAFunction::place_phis() {
+    const uint count = (uint)this->graph.size();
+    const EdgeSpan order = this->graph.reverse_postorder();
+
+    // What each block reads before writing and what it writes, as the lifter will see it
+    VariableMask *uses = this->arena.allocate_array<VariableMask>(count);
+    VariableMask *defs = this->arena.allocate_array<VariableMask>(count);
+    VariableMask *live = this->arena.allocate_array<VariableMask>(count);
+    for (uint b = 0; b < count; ++b) {
+        uses[b] = defs[b] = live[b] = VariableMask {};
+        for (uint i = this->graph[b].first; i <= this->graph[b].last; ++i) {
+            const BranchFlow flow = branch_flow(this->instructions[i], i, this->instructions.size());
+            VariableMask reads, writes;
+            effects_of(this->instructions[i], flow, reads, writes);
+            uses[b] = uses[b] | (reads & ~defs[b]);
+            defs[b] = defs[b] | writes;
+        }
+    }
+
+    // Phis only go where their variable is live, or call clobbers would put one on every join
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = order.size(); i > 0; --i) {
+            const uint b = order[i - 1];
+            VariableMask out = this->graph[b].exits ? RETURN_VARIABLES : VariableMask {};
+            for (uint next : this->graph.successors(b)) {
+                out = out | live[next];
+            }
+            const VariableMask in = uses[b] | (out & ~defs[b]);
+            if (in != live[b]) {
+                live[b] = in;
+                changed = true;
+            }
+        }
+    }
+
+    // Frontiers in compressed rows, counted and then filled
+    uint *offsets = this->arena.allocate_array<uint>(count + 1);
+    for (uint b = 0; b <= count; ++b) {
+        offsets[b] = 0;
+    }
+    for_each_frontier(this->graph, [&](uint runner, uint) {
+        offsets[runner + 1]++;
+    });
+    for (uint b = 0; b < count; ++b) {
+        offsets[b + 1] += offsets[b];
+    }
+    uint *frontier = this->arena.allocate_array<uint>(offsets[count]);
+    uint *fill = this->arena.allocate_array<uint>(count);
+    for (uint b = 0; b < count; ++b) {
+        fill[b] = offsets[b];
+    }
+    for_each_frontier(this->graph, [&](uint runner, uint block) {
+        frontier[fill[runner]++] = block;
+    });
+
+    // Iterated frontiers. A new phi is a write too, and goes on to its own block's frontier
+    VariableMask *phis = this->arena.allocate_array<VariableMask>(count);
+    VariableMask *pending = this->arena.allocate_array<VariableMask>(count);
+    VariableMask *sent = this->arena.allocate_array<VariableMask>(count);
+    ArenaVector<uint> work(this->arena, count);
+    for (uint b = 0; b < count; ++b) {
+        phis[b] = sent[b] = VariableMask {};
+        pending[b] = this->graph.reachable(b) ? defs[b] : VariableMask {};
+        if (pending[b].any()) {
+            work.push_back(b);
+        }
+    }
+    while (!work.empty()) {
+        const uint b = work.back();
+        work.pop_back();
+        const VariableMask out = pending[b];
+        pending[b] = VariableMask {};
+        sent[b] = sent[b] | out;
+        for (uint f = offsets[b]; f < offsets[b + 1]; ++f) {
+            const uint join = frontier[f];
+            const VariableMask added = out & live[join] & ~phis[join];
+            phis[join] = phis[join] | added;
+            const VariableMask next = added & ~sent[join] & ~pending[join];
+            if (next.any()) {
+                if (!pending[join].any()) {
+                    work.push_back(join);
+                }
+                pending[join] = pending[join] | next;
+            }
+        }
+    }
+
+    // Make every phi up front, so a block can fill in its successors' before they're lifted
+    for (uint b = 0; b < count; ++b) {
+        SSABlock& block = this->blocks[b];
+        block.first_phi = (uint)this->values.size();
+        const uint num_operands = (uint)this->graph.predecessors(b).size() + (b == 0 ? 1 : 0);
+        for_each_variable(phis[b], [&](uint v) {
+            const ValueId phi = this->make(Op::PHI, variable_type(v), b, num_operands, NO_VALUE);
+            this->values[phi].variable = (uchar)v;
+            for (uint i = 0; i < num_operands; ++i) {
+                this->set_operand(phi, i, this->undefined);
+            }
+            if (b == 0) {
+                this->set_operand(phi, num_operands - 1, this->current[v]);
+            }
+        });
+        block.num_phis = (uint)this->values.size() - block.first_phi;
+    }
+}
+
+void SSAFunction::rename() {
+    const uint count = (uint)this->graph.size();
+
+    // Dominator tree children in compressed rows
+    uint *offsets = this->arena.allocate_array<uint>(count + 1);
+    for (uint b = 0; b <= count; ++b) {
+        offsets[b] = 0;
+    }
+    for (uint b : this->graph.reverse_postorder()) {
+        if (b != 0) {
+            offsets[this->graph.immediate_dominator(b) + 1]++;
+        }
+    }
+    for (uint b = 0; b < count; ++b) {
+        offsets[b + 1] += offsets[b];
+    }
+    uint *children = this->arena.allocate_array<uint>(offsets[count]);
+    uint *fill = this->arena.allocate_array<uint>(count);
+    for (uint b = 0; b < count; ++b) {
+        fill[b] = offsets[b];
+    }
+    for (uint b : this->graph.reverse_postorder()) {
+        if (b != 0) {
+            const uint parent = this->graph.immediate_dominator(b);
+            children[fill[parent]++] = b;
+        }
+    }
+
+    // Preorder down the tree, each block is lifted with its dominators' definitions in place
+    struct Frame {
+        uint block, saved;
+        bool done;
+    };
+    ArenaVector<Frame> stack(this->arena);
+    stack.push_back(Frame {0, 0, false});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.done) {
+            while (this->saved.size() > frame.saved) {
+                this->current[this->saved.back().variable] = this->saved.back().value;
+                this->saved.pop_back();
+            }
+            stack.pop_back();
+            continue;
+        }
+        frame.done = true;
+        frame.saved = (uint)this->saved.size();
+        const uint block = frame.block;
+
+        this->lift_block(block);
+        for (uint c = offsets[block]; c < offsets[block + 1]; ++c) {
+            stack.push_back(Frame {children[c], 0, false});
+        }
+    }
+}
+
+void SSAFunction::lift_block(uint block) {
+    for (uint p = 0; p < this->blocks[block].num_phis; ++p) {
+        const ValueId phi = this->blocks[block].first_phi + p;
+        this->define(this->values[phi].variable, phi);
+    }
+
+    this->blocks[block].first_value = (uint)this->values.size();
+    for (uint i = this->graph[block].first; i <= this->graph[block].last; ++i) {
+        this->lift(block, i);
+    }
+    this->lift_end(block);
+    this->blocks[block].num_values = (uint)this->values.size() - this->blocks[block].first_value;
+
+    for (uint next : this->graph.successors(block)) {
+        const EdgeSpan prev = this->graph.predecessors(next);
+        const uint slot = (uint)(std::find(prev.begin(), prev.end(), block) - prev.begin());
+        for (uint p = 0; p < this->blocks[next].num_phis; ++p) {
+            const ValueId phi = this->blocks[next].first_phi + p;
+            this->set_operand(phi, slot, this->use(this->values[phi].variable));
+        }
+    }
+}
+
+void SSAFunction::lift(uint block, uint index) {
+    const DecodedInstruction& inst = this->instructions[index];
+    if (branch_flow(inst, index, this->instructions.size()).calls) {
+        this->lift_call(block, index);
+    } else if (!is_branch(inst) && !this->lift_known(block, index)) {
+        this->lift_opaque(block, index);
+    }
+}
+
+bool SSAFunction::lift_known(uint block, uint index) {
+    const DecodedInstruction& inst = this->instructions[index];
+    auto constant = [&](int value) {
+        return this->make_constant(value, block, index);
+    };
+    auto op = [&](Op op, uint first, ValueId second) {
+        return this->binary(op, ValueType::INT, this->use(first), second, block, index);
+    };
+    auto compare = [&](ValueId first, ValueId second, bool logical) {
+        const ValueId out = this->binary(Op::COMPARE, ValueType::CONDITION, first, second, block, index);
+        this->values[out].constant = logical;
+        this->define(CR_VARIABLE + (inst.rd >> 2), out);
+    };
+    const int shifted = (int)((uint)inst.imm << 16);
+
+    if ((inst.opcode == 59 || inst.opcode == 63) && is_record(inst)) {
+        return false;
+    }
+
+    MemoryForm form {};
+    if (memory_form(inst, form)) {
+        const bool update = is_update(inst);
+        const ValueId address = update || inst.ra != 0 ? this->use(inst.ra) : constant(0);
+        const ValueId offset = inst.opcode == 31 ? this->use(inst.rb) : constant(inst.simm());
+        const uint data = (form.type == ValueType::FLOAT ? FPR_VARIABLE : 0) + inst.rd;
+        ValueId out;
+        if (form.store) {
+            out = this->make(Op::STORE, form.type, block, 3, index);
+            this->set_operand(out, 0, this->use(data));
+            this->set_operand(out, 1, address);
+            this->set_operand(out, 2, offset);
+        } else {
+            out = this->binary(Op::LOAD, form.type, address, offset, block, index);
+            this->values[out].constant = form.sign;
+            this->define(data, out);
+        }
+        this->values[out].width = form.width;
+        if (update) {
+            this->define(inst.ra, this->binary(Op::ADD, ValueType::INT, address, offset, block, index));
+        }
+        return true;
+    }
+
+    // Most integer ops write rd, the logical ones write ra from rs in the rd field
+    ValueId result = NO_VALUE;
+    uint dest = inst.rd;
+    switch (inst.opcode) {
+        case 7: result = op(Op::MUL, inst.ra, constant(inst.simm())); break;
+        case 10: compare(this->use(inst.ra), constant(inst.imm), true); return true;
+        case 11: compare(this->use(inst.ra), constant(inst.simm()), false); return true;
+        case 12:
+        case 13: result = op(Op::ADD, inst.ra, constant(inst.simm())); break;
+        case 14:
+            result = inst.ra == 0 ? constant(inst.simm()) : op(Op::ADD, inst.ra, constant(inst.simm()));
+            break;
+        case 15: result = inst.ra == 0 ? constant(shifted) : op(Op::ADD, inst.ra, constant(shifted)); break;
+        case 24:
+            result = inst.imm == 0 ? this->use(inst.rd) : op(Op::OR, inst.rd, constant(inst.imm));
+            dest = inst.ra;
+            break;
+        case 25: result = op(Op::OR, inst.rd, constant(shifted)); dest = inst.ra; break;
+        case 26: result = op(Op::XOR, inst.rd, constant(inst.imm)); dest = inst.ra; break;
+        case 27: result = op(Op::XOR, inst.rd, constant(shifted)); dest = inst.ra; break;
+        case 28: result = op(Op::AND, inst.rd, constant(inst.imm)); dest = inst.ra; break;
+        case 29: result = op(Op::AND, inst.rd, constant(shifted)); dest = inst.ra; break;
+        case 31:
+            switch (inst.xo) {
+                case 0: compare(this->use(inst.ra), this->use(inst.rb), false); return true;
+                case 32: compare(this->use(inst.ra), this->use(inst.rb), true); return true;
+                case 266: result = op(Op::ADD, inst.ra, this->use(inst.rb)); break;
+                case 40: result = op(Op::SUB, inst.rb, this->use(inst.ra)); break;
+                case 235: result = op(Op::MUL, inst.ra, this->use(inst.rb)); break;
+                case 459:
+                case 491: result = op(Op::DIV, inst.ra, this->use(inst.rb)); break;
+                case 104:
+                    result = this->make(Op::NEGATE, ValueType::INT, block, 1, index);
+                    this->set_operand(result, 0, this->use(inst.ra));
+                    break;
+                case 28: result = op(Op::AND, inst.rd, this->use(inst.rb)); dest = inst.ra; break;
+                case 444:
+                    result = inst.rd == inst.rb ? this->use(inst.rd) : op(Op::OR, inst.rd, this->use(inst.rb));
+                    dest = inst.ra;
+                    break;
+                case 316: result = op(Op::XOR, inst.rd, this->use(inst.rb)); dest = inst.ra; break;
+                case 24: result = op(Op::SHIFT_LEFT, inst.rd, this->use(inst.rb)); dest = inst.ra; break;
+                case 536: result = op(Op::SHIFT_RIGHT, inst.rd, this->use(inst.rb)); dest = inst.ra; break;
+                case 792:
+                case 824:
+                    result = op(Op::SHIFT_RIGHT, inst.rd, inst.xo == 824 ? constant(inst.rb) : this->use(inst.rb));
+                    this->values[result].constant = 1;
+                    dest = inst.ra;
+                    break;
+                default: return false;
+            }
+            break;
+        case 59:
+        case 63: {
+            auto fop = [&](Op op, uint first, uint second) {
+                return this->binary(op, ValueType::FLOAT, this->use(FPR_VARIABLE + first),
+                                    this->use(FPR_VARIABLE + second), block, index);
+            };
+            switch (inst.xo) {
+                case 18: result = fop(Op::DIV, inst.ra, inst.rb); break;
+                case 20: result = fop(Op::SUB, inst.ra, inst.rb); break;
+                case 21: result = fop(Op::ADD, inst.ra, inst.rb); break;
+                case 25: result = fop(Op::MUL, inst.ra, inst.rc); break;
+                default:
+                    if (inst.opcode == 59) {
+                        return false;
+                    }
+                    switch (inst.xo) {
+                        case 0:
+                        case 32:
+                            compare(this->use(FPR_VARIABLE + inst.ra), this->use(FPR_VARIABLE + inst.rb), false);
+                            return true;
+                        case 72: result = this->use(FPR_VARIABLE + inst.rb); break;
+                        case 40:
+                            result = this->make(Op::NEGATE, ValueType::FLOAT, block, 1, index);
+                            this->set_operand(result, 0, this->use(FPR_VARIABLE + inst.rb));
+                            break;
+                        default: return false;
+                    }
+            }
+            this->define(FPR_VARIABLE + dest, result);
+            return true;
+        }
+        default:
+            return false;
+    }
+
+    this->define(dest, result);
+    if (is_record(inst)) {
+        const ValueId test = this->binary(Op::COMPARE, ValueType::CONDITION, result, constant(0), block, index);
+        this->values[test].constant = 0;
+        this->define(CR_VARIABLE, test);
+    }
+    return true;
+}
+
+void SSAFunction::lift_opaque(uint block, uint index) {
+    const DecodedInstruction& inst = this->instructions[index];
+    const BranchFlow flow = branch_flow(inst, index, this->instructions.size());
+    VariableMask reads, writes;
+    effects_of(inst, flow, reads, writes);
+
+    uint num_reads = 0;
+    for_each_variable(reads, [&](uint) {
+        num_reads++;
+    });
+    const ValueId out = this->make(Op::OPAQUE, ValueType::NONE, block, num_reads, index);
+    uint slot = 0;
+    for_each_variable(reads, [&](uint v) {
+        this->set_operand(out, slot++, this->use(v));
+    });
+
+    // The value stands for the first register written, the others get results of it
+    bool first = true;
+    for_each_variable(writes, [&](uint v) {
+        ValueId value = out;
+        if (first) {
+            this->values[out].type = variable_type(v);
+            this->values[out].variable = (uchar)v;
+            first = false;
+        } else {
+            value = this->make(Op::RESULT, variable_type(v), block, 1, index);
+            this->set_operand(value, 0, out);
+            this->values[value].variable = (uchar)v;
+        }
+        this->define(v, value);
+    });
+}
+
+void SSAFunction::lift_call(uint block, uint index) {
+    const DecodedInstruction& inst = this->instructions[index];
+    const ValueId call = this->make(Op::CALL, ValueType::INT, block, NUM_ARGUMENTS, index);
+    for (uint r = 0; r < 8; ++r) {
+        this->set_operand(call, r, this->use(3 + r));
+        this->set_operand(call, 8 + r, this->use(FPR_VARIABLE + 1 + r));
+    }
+    this->values[call].constant = inst.opcode == 19 ? 0 : branch_address(inst, this->base + index * 4);
+
+    const VariableMask clobbered {VOLATILE_GPRS, VOLATILE_FPRS, VOLATILE_CRS};
+    for_each_variable(clobbered, [&](uint v) {
+        this->define(v, this->undefined);
+    });
+    this->define(3, call);
+    const ValueId result = this->make(Op::RESULT, ValueType::FLOAT, block, 1, index);
+    this->set_operand(result, 0, call);
+    this->values[result].variable = (uchar)(FPR_VARIABLE + 1);
+    this->define(FPR_VARIABLE + 1, result);
+}
+
+void SSAFunction::lift_return(uint block, uint index, bool conditional) {
+    const DecodedInstruction& inst = this->instructions[index];
+    const uint first = conditional ? 1 : 0;
+    const ValueId out = this->make(conditional ? Op::RETURN_IF : Op::RETURN, ValueType::NONE, block, first + 2, index);
+    if (conditional) {
+        this->set_operand(out, 0, this->use(CR_VARIABLE + (inst.ra >> 2)));
+        this->values[out].constant = (int)((inst.rd << 5) | inst.ra);
+    }
+    this->set_operand(out, first, this->use(3));
+    this->set_operand(out, first + 1, this->use(FPR_VARIABLE + 1));
+}
+
+void SSAFunction::lift_end(uint block) {
+    const uint index = this->graph[block].last;
+    const DecodedInstruction& inst = this->instructions[index];
+    const BranchFlow flow = branch_flow(inst, index, this->instructions.size());
+    const EdgeSpan next = this->graph.successors(block);
+
+    if (is_tail_call(inst, flow)) {
+        this->lift_call(block, index);
+        this->lift_return(block, index, false);
+    } else if (!is_branch(inst) || flow.calls || !flow.exits) {
+        if (next.size() == 2) {
+            const ValueId out = this->make(Op::BRANCH, ValueType::NONE, block, 1, index);
+            this->set_operand(out, 0, this->use(CR_VARIABLE + (inst.ra >> 2)));
+            this->values[out].constant = (int)((inst.rd << 5) | inst.ra);
+        } else if (next.size() == 1) {
+            this->make(Op::JUMP, ValueType::NONE, block, 0, index);
+        } else {
+            // Ran off the end of the function
+            this->lift_return(block, index, false);
+        }
+    } else {
+        this->lift_return(block, index, flow.next);
+    }
+}
+
+std::size_t SSAFunction::size() const {
+    return this->values.size();
+}
+
+const Value& SSAFunction::operator[](ValueId value) const {
+    return this->values[value];
+}
+
+EdgeSpan SSAFunction::operands(ValueId value) const {
+    const Value& item = this->values[value];
+    return EdgeSpan {this->operand_pool.data() + item.first_operand, item.num_operands};
+}
+
+const SSABlock& SSAFunction::block(uint block) const {
+    return this->blocks[block];
+}
+
+const ControlFlowGraph& SSAFunction::get_graph() const {
+    return this->graph;
+}
+
+const FunctionRegisters& SSAFunction::get_registers() const {
+    return this->registers;
+}
+
+ulong SSAFunction::get_base() const {
+    return this->base;
+}
+
+std::size_t SSAFunction::memory_used() const {
+    return this->arena.allocated();
+}
+
+}
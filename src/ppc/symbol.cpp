@@ -1,12 +1,16 @@
 
-#include <set>
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <sstream>
 #include <fstream>
 #include <at_logging>
 
+#include "mapped_file.h"
+#include "parallel.h"
 #include "ppc/symbol.h"
-#include "ppc/instruction.h"
+#include "ppc/symbol_map.h"
+#include "ppc/liveness.h"
 
 namespace PPC {
 
@@ -14,147 +18,312 @@ using std::ios;
 
 static logging::Logger* logger = logging::get_logger("ppc.symb");
 
-Symbol::Symbol(ulong start, ulong end, const std::string& name) {
+Symbol::Symbol(ulong start, ulong end, std::string_view name) {
     this->start = start;
     this->end = end;
     this->name = name;
     
-    this->r_input = std::set<Register>();
+    this->r_input = 0;
+    this->fr_input = 0;
+    this->r_output = 0;
+    this->fr_output = 0;
     this->inputs_made = false;
 }
 
 void Symbol::gen_inputs() {
-    std::set<Register> seen_dests;
-    
-    for (auto i : instructions) {
-        for (auto r : i->source_registers()) {
-            if (!seen_dests.count(r)) {
-                if (r.type == Register::REGULAR) {
-                    r_input.emplace(r);
-                } else if (r.type == Register::FLOAT) {
-                    fr_input.emplace(r);
-                }
-                seen_dests.emplace(r);
-            }
-        }
-        
-        Register r = i->destination_register();
-        seen_dests.emplace(r);
-    }
+    // One analyzer per thread, so its buffers are reused from function to function
+    static thread_local LivenessAnalyzer analyzer;
+    const FunctionRegisters registers = analyzer.analyze(instructions);
+    
+    r_input = registers.gpr_in;
+    fr_input = registers.fpr_in;
+    r_output = registers.gpr_out;
+    fr_output = registers.fpr_out;
+    inputs_made = true;
 }
 
-const std::set<Register>& Symbol::get_input_regular() {
+uint Symbol::get_input_regular() {
     if (!inputs_made)
         gen_inputs();
     return this->r_input;
 }
 
-const std::set<Register>& Symbol::get_input_float() {
+uint Symbol::get_input_float() {
     if (!inputs_made)
         gen_inputs();
     return this->fr_input;
 }
 
-std::vector<Symbol> generate_symbols(const std::string& file_in, int start, int end) {
-    logger->info("Generating symbols");
+uint Symbol::get_output_regular() {
+    if (!inputs_made)
+        gen_inputs();
+    return this->r_output;
+}
+
+uint Symbol::get_output_float() {
+    if (!inputs_made)
+        gen_inputs();
+    return this->fr_output;
+}
+
+void Symbol::set_registers(const FunctionRegisters& registers) {
+    r_input = registers.gpr_in;
+    fr_input = registers.fpr_in;
+    r_output = registers.gpr_out;
+    fr_output = registers.fpr_out;
+    inputs_made = true;
+}
+
+static bool is_return(const DecodedInstruction& inst) {
+    // bctr used to be named blr, it still ends a function so splits stay where they were
+    return inst.is(Mnemonic::BLR) || inst.is(Mnemonic::BCTR) || inst.is(Mnemonic::RFI);
+}
+
+// Index a relative b or bl at index lands on, or count if it isn't one or lands outside the section
+static std::size_t branch_target(const DecodedInstruction& inst, std::size_t index, std::size_t count) {
+    if (inst.mnemonic != Mnemonic::B || (inst.suffix & DecodedInstruction::ABSOLUTE)) {
+        return count;
+    }
+    const long target = (long)index + inst.branch_offset() / 4;
+    if (target < 0 || (std::size_t)target >= count) {
+        return count;
+    }
+    return (std::size_t)target;
+}
+
+// Index a forward bc at index lands on, or 0 if it isn't one or lands outside the section
+static std::size_t conditional_reach(const DecodedInstruction& inst, std::size_t index, std::size_t count) {
+    if (inst.opcode != 16 || (inst.suffix & (DecodedInstruction::LINK | DecodedInstruction::ABSOLUTE))) {
+        return 0;
+    }
+    const long target = (long)index + (short)(inst.word & 0xFFFC) / 4;
+    if (target <= (long)index || (std::size_t)target >= count) {
+        return 0;
+    }
+    return (std::size_t)target;
+}
+
+CallTargets::CallTargets() : CallTargets(0) {}
+
+CallTargets::CallTargets(std::size_t count) : bits((count + 63) / 64), returns((count + 63) / 64) {
+    this->count = count;
+}
+
+std::size_t CallTargets::size() const {
+    return this->count;
+}
+
+void CallTargets::mark(std::size_t index) {
+    this->bits[index / 64] |= (std::uint64_t)1 << (index % 64);
+}
+
+bool CallTargets::contains(std::size_t index) const {
+    return index < this->count && (this->bits[index / 64] >> (index % 64)) & 1u;
+}
+
+void CallTargets::mark_end(std::size_t index) {
+    this->returns[index / 64] |= (std::uint64_t)1 << (index % 64);
+}
+
+bool CallTargets::ends(std::size_t index) const {
+    return index < this->count && (this->returns[index / 64] >> (index % 64)) & 1u;
+}
+
+template<typename Get>
+static CallTargets collect_targets(std::size_t count, Get get) {
+    CallTargets out(count);
     
-    std::fstream input(file_in, ios::in | ios::binary);
+    // Forward, calls and jumps back before the last return. A return that a bc of the same region jumps
+    // past isn't the end of it, the function goes on after. Reach stops at a target already found, since
+    // a new function starts there
+    std::size_t region_start = 0, reach = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const DecodedInstruction inst = get(i);
+        if (out.contains(i)) {
+            reach = 0;
+        }
+        const std::size_t target = branch_target(inst, i, count);
+        if (target != count && ((inst.suffix & DecodedInstruction::LINK) || target < region_start)) {
+            out.mark(target);
+        }
+        reach = std::max(reach, conditional_reach(inst, i, count));
+        if (is_return(inst) && reach <= i) {
+            out.mark_end(i);
+            region_start = i + 1;
+        }
+    }
     
-    if (end == -1) {
-        input.seekg(0, ios::end);
-        end = (int)input.tellg();
+    // Backward, jumps on past the next return
+    std::size_t region_end = count;
+    for (std::size_t i = count; i-- > 0;) {
+        const DecodedInstruction inst = get(i);
+        if (out.ends(i)) {
+            region_end = i;
+        }
+        const std::size_t target = branch_target(inst, i, count);
+        if (target != count && target > region_end) {
+            out.mark(target);
+        }
     }
     
-    std::vector<Symbol> out = std::vector<Symbol>();
-    std::vector<Instruction*> cur_instructions = std::vector<Instruction*>();
-    uint sym_start = start, sym_end = 0, position = start;
-    uchar inst[4];
-    bool skip_padding = true;
+    return out;
+}
+
+CallTargets find_call_targets(InstructionSpan instructions) {
+    return collect_targets(instructions.size(), [&](std::size_t i) {
+        return instructions[i];
+    });
+}
+
+CallTargets find_call_targets(ByteSpan code) {
+    return collect_targets(code.size / 4, [&](std::size_t i) {
+        return decode(code.data + i * 4);
+    });
+}
+
+SymbolSplitter::SymbolSplitter(ulong base, const CallTargets *targets) {
+    this->base = base;
+    this->sym_start = base;
+    this->position = base;
+    this->skip_padding = true;
+    this->ended = false;
+    this->targets = targets;
+}
+
+bool SymbolSplitter::push(const DecodedInstruction& instruction, Symbol& out) {
+    if (ended) {
+        // The last symbol handed out is done with now, so its storage can be reused
+        cur_instructions.clear();
+        ended = false;
+    }
     
-    input.seekg(start, ios::beg);
-    while (input.tellg() < end) {
-        
-        input.read((char*)inst, 4);
-        
-        Instruction* instruction = create_instruction(inst);
+    const std::size_t index = (position - base) / 4;
+    
+    if (instruction.mnemonic == Mnemonic::PADDING && skip_padding) {
+        sym_start += 4;
+    } else {
+        cur_instructions.push_back(instruction);
+        skip_padding = false;
         
-        if (instruction->code_name() == "blr" || instruction->code_name() == "rfi") {
-            sym_end = position;
+        // With targets, only returns that end their region count, and a function also ends right before
+        // one that's called into
+        const bool returns = targets == nullptr ? is_return(instruction) : targets->ends(index);
+        if (returns || (targets != nullptr && targets->contains(index + 1))) {
+            std::stringstream sym_name;
             
-            std::stringstream name;
-            
-            if (instruction->code_name() == "blr") {
-                name << "f_";
-            } else if (instruction->code_name() == "rfi") {
-                name << "i_";
+            if (instruction.mnemonic == Mnemonic::RFI) {
+                sym_name << "i_";
+            } else {
+                sym_name << "f_";
             }
             
-            name << std::hex << sym_start - start;
-            Symbol symb = Symbol(sym_start, sym_end, name.str());
-            symb.instructions = std::move(cur_instructions);
-            out.emplace_back(symb);
+            sym_name << std::hex << sym_start - base;
+            cur_name = sym_name.str();
+            out = Symbol(sym_start, position, cur_name);
+            out.instructions = InstructionSpan(cur_instructions);
+            ended = true;
             
             sym_start = position + 4;
-            cur_instructions = std::vector<Instruction*>();
             skip_padding = true;
-        } else if (instruction->code_name() == "PADDING" && skip_padding) {
-            sym_start += 4;
-        } else {
-            cur_instructions.emplace_back(instruction);
-            skip_padding = false;
         }
-        
-        position += 4;
+    }
+    
+    position += 4;
+    return ended;
+}
+
+std::vector<Symbol> generate_symbols(InstructionSpan instructions, Arena& arena, ulong base) {
+    logger->info("Generating symbols");
+    
+    std::vector<Symbol> out = std::vector<Symbol>();
+    CallTargets targets = find_call_targets(instructions);
+    SymbolSplitter splitter(base, &targets);
+    Symbol symb = Symbol(0, 0, "");
+    
+    for (const auto& instruction : instructions) {
+        if (splitter.push(instruction, symb)) {
+            // Point the kept symbol at the caller's instructions rather than the splitter's copy
+            Symbol kept = Symbol(symb.start, symb.end, arena.copy(symb.name));
+            kept.instructions = instructions.subspan((symb.start - base) / 4, symb.instructions.size());
+            out.push_back(kept);
+        }
     }
     
     logger->info("Symbol generation complete");
     return out;
 }
 
-void generate_inputs(std::vector<Symbol>& symbols) {
-    
-    for (auto& symbol : symbols) {
-        // Go through each instruction, find its inputs
-        
+void generate_inputs(Symbol& symbol) {
+    if (!symbol.inputs_made) {
+        symbol.gen_inputs();
+    }
+}
+
+void generate_inputs(std::vector<Symbol>& symbols, uint jobs) {
+    if (jobs == 1) {
+        for (auto& symbol : symbols) {
+            if (!symbol.inputs_made) {
+                symbol.gen_inputs();
+            }
+        }
+        return;
     }
+    if (jobs == 0) {
+        jobs = hardware_jobs();
+    }
+    
+    // Symbols are handed out in runs, so threads don't fight over the counter or share cache lines
+    constexpr std::size_t RUN = 16;
+    parallel_for((symbols.size() + RUN - 1) / RUN, jobs, [&](std::size_t run) {
+        const std::size_t last = std::min(symbols.size(), (run + 1) * RUN);
+        for (std::size_t i = run * RUN; i < last; ++i) {
+            if (!symbols[i].inputs_made) {
+                symbols[i].gen_inputs();
+            }
+        }
+    });
 }
 
-std::vector<Symbol> load_symbols(const std::string& file_in) {
+std::vector<Symbol> load_symbols(const std::string& file_in, Arena& arena) {
     // TODO: read inputs
     
-    std::fstream input(file_in, ios::in);
+    // Binary maps need no parsing, only their names are copied out of the mapping
+    SymbolMap map(file_in);
+    if (map.is_valid()) {
+        std::vector<Symbol> out = map.symbols();
+        for (auto& symbol : out) {
+            symbol.name = arena.copy(symbol.name);
+        }
+        return out;
+    }
+    
+    MappedFile file(file_in);
+    const char *pos = (const char*)file.bytes().begin(), *end = (const char*)file.bytes().end();
     
     std::vector<Symbol> out = std::vector<Symbol>();
-    std::string line, name;
-    std::stringstream token;
-    uint i = 0;
-    ulong start = 0, end = 0;
-    
-    while (std::getline(input, line)) {
-        for (auto ch : line) {
-            if (ch == ';') {
-                switch (i) {
-                    case 0:
-                        name = token.str();
-                        break;
-                    case 1:
-                        token >> start;
-                        break;
-                    case 2:
-                        token >> end;
-                        break;
-                }
-                
-                token.str("");
-                token.clear();
-                i++;
-            } else {
-                token << ch;
+    while (pos < end) {
+        const char *line_end = (const char*)std::memchr(pos, '\n', (std::size_t)(end - pos));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        
+        // name;start;end
+        std::string_view fields[3];
+        uint i = 0;
+        const char *field = pos;
+        for (const char *ch = pos; ch <= line_end && i < 3; ++ch) {
+            if (ch == line_end || *ch == ';' || *ch == '\r') {
+                fields[i++] = std::string_view(field, (std::size_t)(ch - field));
+                field = ch + 1;
             }
         }
+        pos = line_end + 1;
         
-        Symbol symb = Symbol(start, end, name);
-        i = 0;
+        ulong start, stop;
+        if (i == 3 && std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), start).ec == std::errc() &&
+            std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), stop).ec == std::errc()) {
+            out.emplace_back(start, stop, arena.copy(fields[0]));
+        }
     }
     
     return out;
@@ -0,0 +1,81 @@
+
+#include <algorithm>
+
+#include "ppc/symbol_index.h"
+
+namespace PPC {
+
+SymbolIndex::SymbolIndex() : tree(1), ranks(1) {}
+
+SymbolIndex::SymbolIndex(const std::vector<Symbol>& symbols) {
+    this->sorted.reserve(symbols.size());
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        this->sorted.push_back(Entry {symbols[i].start, symbols[i].end, symbols[i].name, i});
+    }
+    std::stable_sort(this->sorted.begin(), this->sorted.end(), [](const Entry& a, const Entry& b) {
+        return a.start < b.start;
+    });
+    
+    this->tree.resize(this->sorted.size() + 1);
+    this->ranks.resize(this->sorted.size() + 1);
+    this->build(1, 0);
+}
+
+std::size_t SymbolIndex::build(std::size_t slot, std::size_t rank) {
+    // An in-order walk of the tree visits the slots in sorted order
+    if (slot < this->tree.size()) {
+        rank = this->build(2 * slot, rank);
+        this->tree[slot] = this->sorted[rank].start;
+        this->ranks[slot] = (uint)rank;
+        rank = this->build(2 * slot + 1, rank + 1);
+    }
+    return rank;
+}
+
+std::size_t SymbolIndex::lower_rank(ulong address) const {
+    const std::size_t count = this->sorted.size();
+    std::size_t slot = 1;
+    while (slot <= count) {
+        slot = 2 * slot + (this->tree[slot] < address);
+    }
+    // Undo the right turns after the last left one, that left turn was at the answer
+    while (slot & 1u) {
+        slot >>= 1u;
+    }
+    slot >>= 1u;
+    return slot == 0 ? count : this->ranks[slot];
+}
+
+std::size_t SymbolIndex::size() const {
+    return this->sorted.size();
+}
+
+const SymbolIndex::Entry *SymbolIndex::find(ulong address) const {
+    // Last symbol starting at or before address
+    std::size_t rank = this->lower_rank(address + 1);
+    if (rank == 0) {
+        return nullptr;
+    }
+    const Entry *out = &this->sorted[rank - 1];
+    return address <= out->end ? out : nullptr;
+}
+
+const SymbolIndex::Entry *SymbolIndex::at(ulong address) const {
+    std::size_t rank = this->lower_rank(address);
+    if (rank == this->sorted.size() || this->sorted[rank].start != address) {
+        return nullptr;
+    }
+    return &this->sorted[rank];
+}
+
+std::pair<const SymbolIndex::Entry*, const SymbolIndex::Entry*> SymbolIndex::range(ulong first, ulong last) const {
+    const Entry *begin = this->sorted.data() + this->lower_rank(first);
+    const Entry *holder = this->find(first);
+    if (holder != nullptr) {
+        begin = holder;
+    }
+    const Entry *end = this->sorted.data() + this->lower_rank(last);
+    return std::make_pair(begin, std::max(begin, end));
+}
+
+}
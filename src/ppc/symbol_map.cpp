@@ -0,0 +1,199 @@
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <at_logging>
+
+#include "ppc/symbol_map.h"
+
+namespace PPC {
+
+static logging::Logger *logger = logging::get_logger("ppc.map");
+
+static const char SYMBOL_MAP_MAGIC[4] = {'G', 'C', 'D', 'S'};
+
+static std::size_t align(std::size_t size) {
+    return (size + 3) & ~(std::size_t)3;
+}
+
+void write_symbol_map(const std::vector<Symbol>& symbols, const std::string& output) {
+    std::vector<const Symbol*> sorted;
+    sorted.reserve(symbols.size());
+    for (const auto& symbol : symbols) {
+        sorted.push_back(&symbol);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Symbol *a, const Symbol *b) {
+        return a->start < b->start;
+    });
+    
+    std::vector<SymbolMapRecord> records;
+    records.reserve(sorted.size());
+    std::string names;
+    for (const auto symbol : sorted) {
+        records.push_back(SymbolMapRecord {(uint)symbol->start, (uint)symbol->end, (uint)names.size(),
+                                           (uint)symbol->name.size()});
+        names += symbol->name;
+    }
+    
+    SymbolMapHeader header {};
+    std::memcpy(header.magic, SYMBOL_MAP_MAGIC, sizeof(SYMBOL_MAP_MAGIC));
+    header.version = SYMBOL_MAP_VERSION;
+    header.count = (uint)records.size();
+    header.names_size = (uint)names.size();
+    
+    static const char padding[4] = {};
+    std::ofstream out(output, std::ios::out | std::ios::binary);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)records.data(), (std::streamsize)(records.size() * sizeof(SymbolMapRecord)));
+    out.write(names.data(), (std::streamsize)names.size());
+    out.write(padding, (std::streamsize)(align(names.size()) - names.size()));
+}
+
+SymbolMap::SymbolMap(const std::string& filename) : file(filename) {
+    this->header = nullptr;
+    this->records = nullptr;
+    this->names = nullptr;
+    
+    ByteSpan bytes = this->file.bytes();
+    if (bytes.size < sizeof(SymbolMapHeader)) {
+        return;
+    }
+    const SymbolMapHeader *head = (const SymbolMapHeader*)bytes.data;
+    if (std::memcmp(head->magic, SYMBOL_MAP_MAGIC, sizeof(SYMBOL_MAP_MAGIC)) != 0 ||
+        head->version != SYMBOL_MAP_VERSION) {
+        return;
+    }
+    
+    const std::size_t names_at = sizeof(SymbolMapHeader) + (std::size_t)head->count * sizeof(SymbolMapRecord);
+    if (names_at + head->names_size > bytes.size) {
+        logger->warn("Symbol map " + filename + " is truncated");
+        return;
+    }
+    
+    this->header = head;
+    this->records = (const SymbolMapRecord*)(bytes.data + sizeof(SymbolMapHeader));
+    this->names = (const char*)(bytes.data + names_at);
+}
+
+bool SymbolMap::is_valid() const {
+    return this->header != nullptr;
+}
+
+std::size_t SymbolMap::size() const {
+    return this->header == nullptr ? 0 : this->header->count;
+}
+
+const SymbolMapRecord& SymbolMap::operator[](std::size_t index) const {
+    return this->records[index];
+}
+
+std::string_view SymbolMap::name(const SymbolMapRecord& record) const {
+    return std::string_view(this->names + record.name, record.name_length);
+}
+
+const SymbolMapRecord *SymbolMap::find(ulong address) const {
+    const SymbolMapRecord *end = this->records + this->size();
+    auto before = [](const SymbolMapRecord& record, ulong value) {
+        return record.start < value;
+    };
+    const SymbolMapRecord *found = std::lower_bound(this->records, end, address, before);
+    return found != end && found->start == address ? found : nullptr;
+}
+
+ByteSpan SymbolMap::bytes() const {
+    return this->file.bytes();
+}
+
+std::vector<Symbol> SymbolMap::symbols() const {
+    std::vector<Symbol> out;
+    out.reserve(this->size());
+    for (std::size_t i = 0; i < this->size(); ++i) {
+        out.emplace_back(this->records[i].start, this->records[i].end, this->name(this->records[i]));
+    }
+    return out;
+}
+
+// Walks a line of a map file a whitespace separated token at a time
+class MapLine {
+    
+    const char *pos, *end;
+
+public:
+    
+    MapLine(const char *start, const char *end) : pos(start), end(end) {}
+    
+    std::string_view token() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+            pos++;
+        }
+        const char *start = pos;
+        while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r') {
+            pos++;
+        }
+        return std::string_view(start, (std::size_t)(pos - start));
+    }
+    
+};
+
+static bool parse_number(std::string_view text, ulong& out, int base) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), out, base);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+std::vector<Symbol> import_map(ByteSpan text, Arena& arena) {
+    std::vector<Symbol> out;
+    const char *pos = (const char*)text.begin(), *end = (const char*)text.end();
+    bool in_layout = false;
+    
+    while (pos < end) {
+        const char *line_end = (const char*)std::memchr(pos, '\n', (std::size_t)(end - pos));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        std::string_view line(pos, (std::size_t)(line_end - pos));
+        pos = line_end + 1;
+        
+        if (line.find("section layout") != std::string_view::npos) {
+            in_layout = true;
+            continue;
+        } else if (line.find("Memory map:") != std::string_view::npos) {
+            in_layout = false;
+        }
+        if (!in_layout) {
+            continue;
+        }
+        
+        // start size virtual [alignment] name [object...]
+        MapLine tokens(line.data(), line.data() + line.size());
+        ulong start, size, address, alignment;
+        if (!parse_number(tokens.token(), start, 16) || !parse_number(tokens.token(), size, 16) ||
+            !parse_number(tokens.token(), address, 16)) {
+            continue;
+        }
+        std::string_view name = tokens.token();
+        std::string_view after = tokens.token();
+        if (!after.empty() && parse_number(name, alignment, 10)) {
+            name = after;
+        }
+        // Section and object entries start with a dot, and zero sized labels cover nothing
+        if (name.empty() || name[0] == '.' || size == 0) {
+            continue;
+        }
+        
+        // Data can be any size, round it out to whole words so end is never before start
+        out.emplace_back(address, address + ((size + 3) & ~(ulong)3) - 4, arena.copy(name));
+    }
+    
+    return out;
+}
+
+std::vector<Symbol> import_map(const std::string& filename, Arena& arena) {
+    MappedFile file(filename);
+    return import_map(file.bytes(), arena);
+}
+
+}
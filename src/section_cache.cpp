@@ -0,0 +1,127 @@
+
+#include <sstream>
+#include <iomanip>
+#include <experimental/filesystem>
+#include <at_logging>
+
+#include "section_cache.h"
+
+namespace fs = std::experimental::filesystem;
+
+static logging::Logger *logger = logging::get_logger("section_cache");
+
+static constexpr std::uint64_t PRIME_1 = 11400714785074694791ULL;
+static constexpr std::uint64_t PRIME_2 = 14029467366897019727ULL;
+static constexpr std::uint64_t PRIME_3 = 1609587929392839161ULL;
+static constexpr std::uint64_t PRIME_4 = 9650029242287828579ULL;
+static constexpr std::uint64_t PRIME_5 = 2870177450012600261ULL;
+
+static inline std::uint64_t rotate(std::uint64_t value, uint amount) {
+	return (value << amount) | (value >> (64 - amount));
+}
+
+static inline std::uint64_t read_64(const uchar *data) {
+	std::uint64_t out = 0;
+	for (uint i = 8; i > 0; --i) {
+		out = (out << 8) | data[i - 1];
+	}
+	return out;
+}
+
+static inline std::uint64_t read_32(const uchar *data) {
+	return (std::uint64_t)data[0] | ((std::uint64_t)data[1] << 8) | ((std::uint64_t)data[2] << 16) |
+	       ((std::uint64_t)data[3] << 24);
+}
+
+static inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+	return rotate(acc + input * PRIME_2, 31) * PRIME_1;
+}
+
+static inline std::uint64_t merge(std::uint64_t acc, std::uint64_t value) {
+	return (acc ^ round(0, value)) * PRIME_1 + PRIME_4;
+}
+
+std::uint64_t hash_bytes(ByteSpan bytes, std::uint64_t seed) {
+	const uchar *pos = bytes.begin();
+	const uchar *end = bytes.end();
+	std::uint64_t out;
+
+	if (bytes.size >= 32) {
+		std::uint64_t v1 = seed + PRIME_1 + PRIME_2, v2 = seed + PRIME_2, v3 = seed, v4 = seed - PRIME_1;
+		for (; pos + 32 <= end; pos += 32) {
+			v1 = round(v1, read_64(pos));
+			v2 = round(v2, read_64(pos + 8));
+			v3 = round(v3, read_64(pos + 16));
+			v4 = round(v4, read_64(pos + 24));
+		}
+		out = rotate(v1, 1) + rotate(v2, 7) + rotate(v3, 12) + rotate(v4, 18);
+		out = merge(out, v1);
+		out = merge(out, v2);
+		out = merge(out, v3);
+		out = merge(out, v4);
+	} else {
+		out = seed + PRIME_5;
+	}
+	out += bytes.size;
+
+	for (; pos + 8 <= end; pos += 8) {
+		out = rotate(out ^ round(0, read_64(pos)), 27) * PRIME_1 + PRIME_4;
+	}
+	if (pos + 4 <= end) {
+		out = rotate(out ^ (read_32(pos) * PRIME_1), 23) * PRIME_2 + PRIME_3;
+		pos += 4;
+	}
+	for (; pos < end; ++pos) {
+		out = rotate(out ^ (*pos * PRIME_5), 11) * PRIME_1;
+	}
+
+	out ^= out >> 33;
+	out *= PRIME_2;
+	out ^= out >> 29;
+	out *= PRIME_3;
+	out ^= out >> 32;
+	return out;
+}
+
+SectionCache::SectionCache(const std::string& directory) {
+	this->directory = directory;
+	fs::create_directories(fs::path(directory));
+}
+
+std::string SectionCache::path(const std::string& key) const {
+	return (fs::path(this->directory) / key).string();
+}
+
+std::string SectionCache::make_key(ByteSpan code, ulong base, const std::string& options) {
+	std::stringstream settings;
+	settings << FORMAT_VERSION << ' ' << base << ' ' << options;
+	std::string text = settings.str();
+	std::uint64_t seed = hash_bytes(ByteSpan((const uchar*)text.data(), text.size()));
+
+	std::stringstream out;
+	out << std::hex << std::setfill('0') << std::setw(16) << hash_bytes(code, seed);
+	return out.str();
+}
+
+bool SectionCache::fetch(const std::string& key, const std::string& filename) const {
+	std::error_code error;
+	fs::copy_file(this->path(key), filename, fs::copy_options::overwrite_existing, error);
+	if (error) {
+		return false;
+	}
+	logger->debug("Reused cached " + filename);
+	return true;
+}
+
+void SectionCache::store(const std::string& key, const std::string& filename) const {
+	// Copy then rename, so a half written entry is never picked up
+	std::string entry = this->path(key);
+	std::error_code error;
+	fs::copy_file(filename, entry + ".tmp", fs::copy_options::overwrite_existing, error);
+	if (!error) {
+		fs::rename(entry + ".tmp", entry, error);
+	}
+	if (error) {
+		logger->warn("Couldn't cache " + filename + ": " + error.message());
+	}
+}
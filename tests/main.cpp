@@ -4,9 +4,25 @@
 #include "datatypes/test_color.h"
 #include "filetypes/test_png.h"
 #include "filetypes/test_tpl.h"
+#include "ppc/test_batch.h"
+#include "ppc/test_call_graph.h"
+#include "ppc/test_cfg.h"
+#include "ppc/test_code_section.h"
+#include "ppc/test_decode_cache.h"
+#include "ppc/test_decompiler.h"
+#include "ppc/test_disassembler.h"
+#include "ppc/test_index.h"
 #include "ppc/test_instructions.h"
+#include "ppc/test_listing.h"
+#include "ppc/test_liveness.h"
 #include "ppc/test_registers.h"
+#include "ppc/test_ssa.h"
+#include "ppc/test_symbol_index.h"
+#include "ppc/test_symbol_map.h"
 #include "ppc/test_symbols.h"
+#include "test_arena.h"
+#include "test_parallel.h"
+#include "test_section_cache.h"
 
 int main(int argc, char** argv) {
     testing::setup_tests(argc, argv);
@@ -16,10 +32,27 @@ int main(int argc, char** argv) {
     TEST_FILE(png)
     TEST_FILE(tpl)
     
+    TEST_FILE(batch)
+    TEST_FILE(call_graph)
+    TEST_FILE(cfg)
+    TEST_FILE(code_section)
+    TEST_FILE(decode_cache)
+    TEST_FILE(decompiler)
+    TEST_FILE(disassembler)
+    TEST_FILE(index)
     TEST_FILE(instructions)
+    TEST_FILE(listing)
+    TEST_FILE(liveness)
     TEST_FILE(registers)
+    TEST_FILE(ssa)
+    TEST_FILE(symbol_index)
+    TEST_FILE(symbol_map)
     TEST_FILE(symbols)
     
+    TEST_FILE(arena)
+    TEST_FILE(parallel)
+    TEST_FILE(section_cache)
+    
     int result = (int)(testing::run_tests("GCDecompiler") & 0b011u);
     
     testing::teardown_tests();
@@ -0,0 +1,36 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_batch.h"
+#include "ppc/batch.h"
+#include "ppc/decoder.h"
+
+void test_decode_range() {
+    // Enough words to cover every vector width plus a scalar tail, and a trailing partial word
+    std::vector<uchar> data;
+    uint seed = 0x12345678;
+    for (uint i = 0; i < 37 * 4 + 3; ++i) {
+        seed = seed * 1103515245 + 12345;
+        data.push_back((uchar)(seed >> 16));
+    }
+    
+    PPC::DecodedBlock block;
+    PPC::decode_range(data.data(), data.size(), block);
+    
+    ASSERT(block.size() == 37);
+    for (uint i = 0; i < block.size(); ++i) {
+        PPC::DecodedInstruction expected = PPC::decode(data.data() + i * 4);
+        PPC::DecodedInstruction actual = block.get(i);
+        
+        ASSERT(actual.word == expected.word);
+        ASSERT(actual.opcode == expected.opcode);
+        ASSERT(actual.xo == expected.xo);
+        ASSERT(actual.rd == expected.rd && actual.ra == expected.ra && actual.rb == expected.rb);
+        ASSERT(actual.rc == expected.rc);
+        ASSERT(actual.imm == expected.imm);
+    }
+}
+
+void run_batch_tests() {
+    TEST(test_decode_range)
+}
@@ -0,0 +1,156 @@
+#include <cstdio>
+#include <vector>
+#include <at_tests>
+
+#include "test_call_graph.h"
+#include "mapped_file.h"
+#include "ppc/call_graph.h"
+
+static std::vector<uchar> to_bytes(const std::vector<uint>& words) {
+    std::vector<uchar> out;
+    for (uint word : words) {
+        out.push_back((uchar)(word >> 24));
+        out.push_back((uchar)(word >> 16));
+        out.push_back((uchar)(word >> 8));
+        out.push_back((uchar)word);
+    }
+    return out;
+}
+
+static constexpr uint r(uint number) {
+    return 1u << number;
+}
+
+// A caller of a leaf, and a pair of functions calling each other
+static std::vector<uint> make_words(uint leaf) {
+    return {
+        0x48000009,     // 0x00 f0: bl f1
+        0x4E800020,     //          blr
+        leaf,           // 0x08 f1
+        0x4E800020,     //          blr
+        0x48000009,     // 0x10 f2: bl f3
+        0x4E800020,     //          blr
+        0x38840001,     // 0x18 f3: addi r4, r4, 1
+        0x4BFFFFF5,     //          bl f2
+        0x4E800020,     //          blr
+    };
+}
+
+static const uint ADD_R3_R4 = 0x7C632214;   // add r3, r3, r4
+
+void test_call_graph_components() {
+    std::vector<uchar> code = to_bytes(make_words(ADD_R3_R4));
+    PPC::CodeSection section {ByteSpan(code)};
+    PPC::CallGraph graph(std::vector<PPC::CodeSection*> {&section});
+    
+    ASSERT(graph.size() == 4);
+    ASSERT(graph.calls(0).size() == 1 && graph.calls(0)[0] == 1);
+    ASSERT(graph.calls(1).empty());
+    ASSERT(graph.calls(3).size() == 1 && graph.calls(3)[0] == 2);
+    
+    ASSERT(graph.num_components() == 3);
+    ASSERT(graph.component_of(1) < graph.component_of(0));
+    ASSERT(graph.component_of(2) == graph.component_of(3));
+    PPC::EdgeSpan pair = graph.members(graph.component_of(2));
+    ASSERT(pair.size() == 2 && pair[0] == 2 && pair[1] == 3);
+}
+
+void test_call_graph_summaries() {
+    std::vector<uchar> code = to_bytes(make_words(ADD_R3_R4));
+    PPC::CodeSection serial {ByteSpan(code)}, parallel {ByteSpan(code)};
+    PPC::CallGraph graph(std::vector<PPC::CodeSection*> {&serial});
+    graph.summarize(1);
+    
+    // The caller takes what the leaf does and gives back its result
+    ASSERT(graph.summary(1).gpr_in == (r(3) | r(4)));
+    ASSERT(graph.summary(0).gpr_in == (r(3) | r(4)));
+    ASSERT(graph.summary(0).gpr_out == r(3));
+    ASSERT(serial.get_symbols()[0].get_output_regular() == r(3));
+    // Round the cycle, f2 needs the r4 that f3 reads
+    ASSERT(graph.summary(2).gpr_in == r(4));
+    ASSERT(graph.summary(2).gpr_clobber == r(4));
+    
+    PPC::CallGraph other(std::vector<PPC::CodeSection*> {&parallel});
+    PPC::SummaryStats stats = other.summarize(4);
+    ASSERT(stats.computed == 3 && stats.reused == 0);
+    for (uint f = 0; f < graph.size(); ++f) {
+        ASSERT(parallel.get_symbols()[f].get_input_regular() == serial.get_symbols()[f].get_input_regular());
+        ASSERT(parallel.get_symbols()[f].get_output_regular() == serial.get_symbols()[f].get_output_regular());
+    }
+}
+
+void test_call_graph_cache() {
+    std::remove("./test_summaries.bin");
+    auto summarize = [](uint leaf) {
+        std::vector<uchar> code = to_bytes(make_words(leaf));
+        PPC::CodeSection section {ByteSpan(code)};
+        PPC::CallGraph graph(std::vector<PPC::CodeSection*> {&section});
+        PPC::SummaryCache cache("./test_summaries.bin");
+        PPC::SummaryStats stats = graph.summarize(2, &cache);
+        cache.save();
+        return stats;
+    };
+    
+    PPC::SummaryStats stats = summarize(ADD_R3_R4);
+    ASSERT(stats.computed == 3 && stats.reused == 0);
+    ASSERT(PPC::SummaryCache("./test_summaries.bin").size() == 4);
+    stats = summarize(ADD_R3_R4);
+    ASSERT(stats.computed == 0 && stats.reused == 3);
+    
+    // Same registers in a different order, only the leaf is redone
+    stats = summarize(0x7C641A14);      // add r3, r4, r3
+    ASSERT(stats.computed == 1 && stats.reused == 2);
+    // A new input changes the leaf's summary, so its caller is redone too
+    stats = summarize(0x7C632A14);      // add r3, r3, r5
+    ASSERT(stats.computed == 2 && stats.reused == 1);
+    
+    std::remove("./test_summaries.bin");
+}
+
+void test_call_graph_saved_registers() {
+    std::vector<uchar> code = to_bytes({
+        0x38650000,     // 0x00 f0: addi r3, r5, 0
+        0x48000009,     //          bl f1
+        0x4E800020,     //          blr
+        0x93E1FFFC,     // 0x0C f1: stw r31, -0x4(r1)
+        0x7C7F1B78,     //          mr r31, r3
+        0x7FE3FB78,     //          mr r3, r31
+        0x83E1FFFC,     //          lwz r31, -0x4(r1)
+        0x4E800020,     //          blr
+    });
+    PPC::CodeSection section {ByteSpan(code)};
+    PPC::CallGraph graph(std::vector<PPC::CodeSection*> {&section});
+    graph.summarize(1);
+    
+    // The callee's saves of r1 and r31 aren't arguments, so they don't reach its caller either
+    ASSERT(graph.summary(1).gpr_in == r(3));
+    ASSERT(graph.summary(0).gpr_in == r(5));
+    ASSERT(section.get_symbols()[0].get_input_regular() == r(5));
+}
+
+void test_call_graph_sections() {
+    // The caller is loaded at 0x80003000 and the leaf at 0x80010000, in that order in the file
+    std::vector<uchar> caller = to_bytes({
+        0x4800D001,     // bl 0x80010000
+        0x4E800020,     // blr
+    });
+    std::vector<uchar> leaf = to_bytes({ADD_R3_R4, 0x4E800020});
+    PPC::CodeSection first {ByteSpan(caller), 0x100}, second {ByteSpan(leaf), 0x2000};
+    
+    PPC::CallGraph placed(std::vector<PPC::CodeSection*> {&first, &second}, {0x80003000, 0x80010000});
+    ASSERT(placed.calls(0).size() == 1 && placed.calls(0)[0] == 1);
+    placed.summarize(1);
+    ASSERT(placed.summary(0).gpr_in == (r(3) | r(4)));
+    
+    // Without addresses the call can't be placed, so it isn't followed
+    PPC::CallGraph relocated(std::vector<PPC::CodeSection*> {&first, &second});
+    ASSERT(relocated.calls(0).size() == 1 && relocated.calls(0)[0] == PPC::CallGraph::NONE);
+}
+
+void run_call_graph_tests() {
+    TEST(test_call_graph_components)
+    TEST(test_call_graph_summaries)
+    TEST(test_call_graph_saved_registers)
+    TEST(test_call_graph_sections)
+    TEST(test_call_graph_cache)
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void run_call_graph_tests();
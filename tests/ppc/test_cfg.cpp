@@ -0,0 +1,117 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_cfg.h"
+#include "ppc/cfg.h"
+
+static std::vector<PPC::DecodedInstruction> decode_all(const std::vector<uint>& words) {
+    std::vector<PPC::DecodedInstruction> out;
+    for (uint word : words) {
+        out.push_back(PPC::decode(word));
+    }
+    return out;
+}
+
+// An if/else, then a loop, with a block nothing reaches
+static const std::vector<uint> words = {
+    0x2C030000,     // 0: cmpwi r3, 0
+    0x4182000C,     // 1: beq +0xC
+    0x38600001,     // 2: li r3, 1
+    0x48000008,     // 3: b +0x8
+    0x38600002,     // 4: li r3, 2
+    0x38630001,     // 5: addi r3, r3, 1
+    0x2C030010,     // 6: cmpwi r3, 0x10
+    0x4180FFF8,     // 7: blt -0x8
+    0x4E800020,     // 8: blr
+    0x38600003,     // 9: li r3, 3
+    0x4E800020,     // 10: blr
+};
+
+void test_cfg_blocks() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all(words);
+    PPC::ControlFlowGraph graph(instructions);
+    
+    ASSERT(graph.size() == 6);
+    ASSERT(graph[0].first == 0 && graph[0].last == 1);
+    ASSERT(graph[1].first == 2 && graph[1].last == 3);
+    ASSERT(graph[2].first == 4 && graph[2].last == 4);
+    ASSERT(graph[3].first == 5 && graph[3].last == 7);
+    ASSERT(graph[4].first == 8 && graph[4].exits);
+    ASSERT(graph[5].first == 9 && graph[5].last == 10);
+    ASSERT(!graph[3].exits);
+    ASSERT(graph.block_of(6) == 3);
+    ASSERT(graph.block_of(10) == 5);
+    
+    PPC::EdgeSpan next = graph.successors(0);
+    ASSERT(next.size() == 2 && next[0] == 1 && next[1] == 2);
+    next = graph.successors(3);
+    ASSERT(next.size() == 2 && next[0] == 4 && next[1] == 3);
+    ASSERT(graph.successors(4).empty());
+    
+    PPC::EdgeSpan prev = graph.predecessors(3);
+    ASSERT(prev.size() == 3);
+    ASSERT(prev[0] == 1 && prev[1] == 2 && prev[2] == 3);
+    ASSERT(graph.predecessors(5).empty());
+}
+
+void test_cfg_order() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all(words);
+    PPC::ControlFlowGraph graph(instructions);
+    
+    PPC::EdgeSpan order = graph.reverse_postorder();
+    ASSERT(order.size() == 5);
+    ASSERT(order[0] == 0);
+    // The join comes after both arms, and the exit after the loop
+    std::vector<uint> position(graph.size(), 100);
+    for (uint i = 0; i < order.size(); ++i) {
+        position[order[i]] = i;
+    }
+    ASSERT(position[3] > position[1] && position[3] > position[2]);
+    ASSERT(position[4] > position[3]);
+    ASSERT(!graph.reachable(5));
+}
+
+void test_cfg_dominators() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all(words);
+    PPC::ControlFlowGraph graph(instructions);
+    
+    ASSERT(graph.immediate_dominator(0) == 0);
+    ASSERT(graph.immediate_dominator(1) == 0);
+    ASSERT(graph.immediate_dominator(2) == 0);
+    // Either arm can reach the join, so neither dominates it
+    ASSERT(graph.immediate_dominator(3) == 0);
+    ASSERT(graph.immediate_dominator(4) == 3);
+    ASSERT(graph.immediate_dominator(5) == PPC::ControlFlowGraph::NONE);
+    
+    ASSERT(graph.dominates(0, 4));
+    ASSERT(graph.dominates(3, 3));
+    ASSERT(!graph.dominates(1, 3));
+    ASSERT(!graph.dominates(0, 5));
+}
+
+void test_cfg_rebuild() {
+    PPC::ControlFlowGraph graph;
+    ASSERT(graph.size() == 0);
+    
+    std::vector<PPC::DecodedInstruction> instructions = decode_all(words);
+    graph.build(instructions);
+    ASSERT(graph.size() == 6);
+    
+    // A conditional branch to the next instruction is one edge, not two
+    instructions = decode_all({0x41820004, 0x4E800020});
+    graph.build(instructions);
+    ASSERT(graph.size() == 2);
+    ASSERT(graph.successors(0).size() == 1);
+    ASSERT(graph.predecessors(1).size() == 1);
+    ASSERT(graph.immediate_dominator(1) == 0);
+    
+    graph.build(PPC::InstructionSpan());
+    ASSERT(graph.size() == 0);
+}
+
+void run_cfg_tests() {
+    TEST(test_cfg_blocks)
+    TEST(test_cfg_order)
+    TEST(test_cfg_dominators)
+    TEST(test_cfg_rebuild)
+}
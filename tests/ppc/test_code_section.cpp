@@ -0,0 +1,42 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_code_section.h"
+#include "ppc/code_section.h"
+
+static const std::vector<uchar> code = {
+    0x7C, 0x08, 0x02, 0xA6,     // mflr r0
+    0x7C, 0x64, 0x1A, 0x14,     // add r3, r4, r3
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0xFC, 0x20, 0x10, 0x90,     // fmr fr1, fr2
+    0x4E, 0x80, 0x00, 0x20,     // blr
+};
+
+void test_decode_once() {
+    PPC::CodeSection section(ByteSpan(code), 0x40);
+    
+    ASSERT(section.get_base() == 0x40);
+    ASSERT(section.get_instructions().size() == 5);
+    ASSERT(section.get_instructions()[3].mnemonic == PPC::Mnemonic::FMR);
+    
+    // Symbols are made once and then kept
+    std::vector<PPC::Symbol>& symbols = section.get_symbols();
+    ASSERT(symbols.size() == 2);
+    ASSERT(&section.get_symbols() == &symbols);
+    ASSERT(symbols[1].start == 0x4C);
+}
+
+void test_section_inputs() {
+    PPC::CodeSection section {ByteSpan(code)};
+    std::vector<PPC::Symbol>& symbols = section.get_symbols_with_inputs();
+    
+    ASSERT(symbols[0].get_input_regular() == ((1u << 3) | (1u << 4)));
+    ASSERT(symbols[0].get_input_float() == 0);
+    ASSERT(symbols[1].get_input_regular() == 0);
+    ASSERT(symbols[1].get_input_float() == (1u << 2));
+}
+
+void run_code_section_tests() {
+    TEST(test_decode_once)
+    TEST(test_section_inputs)
+}
@@ -0,0 +1,48 @@
+#include <string>
+#include <at_tests>
+
+#include "test_decode_cache.h"
+#include "ppc/decode_cache.h"
+#include "ppc/decoder.h"
+
+void test_decode_cached() {
+    PPC::set_decode_cache(true);
+    PPC::reset_decode_cache_stats();
+    
+    // stw r0, 0x14(r1)
+    const PPC::CachedInstruction& first = PPC::decode_cached(0x90010014u);
+    ASSERT(first.decoded.word == 0x90010014u);
+    ASSERT(std::string(first.operands, first.operand_length) == "r0, 0x14(r1)");
+    
+    PPC::decode_cached(0x90010014u);
+    PPC::decode_cached(0x90010014u);
+    // mflr r0
+    const PPC::CachedInstruction& second = PPC::decode_cached(0x7C0802A6u);
+    ASSERT(second.decoded.mnemonic == PPC::Mnemonic::MFLR);
+    ASSERT(std::string(second.operands, second.operand_length) == "r0");
+    
+    PPC::CacheStats stats = PPC::decode_cache_stats();
+    ASSERT(stats.hits == 2);
+    ASSERT(stats.misses == 2);
+    
+    PPC::set_decode_cache(false);
+}
+
+void test_decode_uncached() {
+    PPC::set_decode_cache(false);
+    PPC::reset_decode_cache_stats();
+    
+    const PPC::CachedInstruction& first = PPC::decode_cached(0x90010014u);
+    ASSERT(first.decoded.word == 0x90010014u);
+    const PPC::CachedInstruction& second = PPC::decode_cached(0x7C0802A6u);
+    ASSERT(second.decoded.word == 0x7C0802A6u);
+    ASSERT(PPC::get_variables(PPC::decode(0x90010014u)) == "r0, 0x14(r1)");
+    
+    PPC::CacheStats stats = PPC::decode_cache_stats();
+    ASSERT(stats.hits == 0 && stats.misses == 0);
+}
+
+void run_decode_cache_tests() {
+    TEST(test_decode_cached)
+    TEST(test_decode_uncached)
+}
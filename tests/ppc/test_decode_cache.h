@@ -0,0 +1,3 @@
+#pragma once
+
+void run_decode_cache_tests();
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <at_tests>
+
+#include "test_decompiler.h"
+#include "mapped_file.h"
+#include "ppc/decompiler.h"
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream input(filename);
+    std::stringstream out;
+    out << input.rdbuf();
+    return out.str();
+}
+
+static void push_word(std::vector<uchar>& code, uint word) {
+    code.push_back((uchar)(word >> 24));
+    code.push_back((uchar)(word >> 16));
+    code.push_back((uchar)(word >> 8));
+    code.push_back((uchar)word);
+}
+
+void test_decompile_batch() {
+    // Two sections of very different sizes, one calling between its own functions
+    std::vector<uchar> small, large;
+    push_word(small, 0x38630001u);
+    push_word(small, 0x4E800020u);
+    for (uint i = 0; i < 300; ++i) {
+        push_word(large, 0x7C0802A6u);
+        for (uint j = 0; j < i % 40; ++j) {
+            push_word(large, 0x38630000u | j);
+        }
+        push_word(large, i ? 0x4BFFFFF5u - 4 * (i % 40) : 0x60000000u);
+        push_word(large, 0x4E800020u);
+    }
+    
+    PPC::decompile(ByteSpan(small), "./test_small.c", 0x100, 1);
+    PPC::decompile(ByteSpan(large), "./test_large.c", 0x200, 1);
+    
+    std::vector<PPC::DecompileUnit> units = {
+        {ByteSpan(small), 0x100, "./test_batch_small.c"},
+        {ByteSpan(large), 0x200, "./test_batch_large.c"},
+        {ByteSpan(), 0x300, "./test_batch_empty.c"}
+    };
+    PPC::decompile(units, 4);
+    
+    std::string small_out = read_file("./test_small.c"), large_out = read_file("./test_large.c");
+    ASSERT(small_out.find("int32_t f_0(int32_t r3) {\n") == 0);
+    ASSERT(large_out.find("f_4(") != std::string::npos);
+    ASSERT(read_file("./test_batch_small.c") == small_out);
+    ASSERT(read_file("./test_batch_large.c") == large_out);
+    ASSERT(read_file("./test_batch_empty.c").empty());
+}
+
+void test_decompile_sections() {
+    // A call from one placed section into the second function of another, at 0x80010008
+    std::vector<uchar> caller, callee;
+    push_word(caller, 0x4800D009u);
+    push_word(caller, 0x4E800020u);
+    push_word(callee, 0x38600000u);
+    push_word(callee, 0x4E800020u);
+    push_word(callee, 0x7C632214u);
+    push_word(callee, 0x4E800020u);
+    
+    std::vector<PPC::DecompileUnit> units = {
+        {ByteSpan(caller), 0x100, "./test_sections_caller.c", 0x80003000},
+        {ByteSpan(callee), 0x2000, "./test_sections_callee.c", 0x80010000}
+    };
+    PPC::decompile(units, 2);
+    
+    const std::string caller_out = read_file("./test_sections_caller.c");
+    ASSERT(read_file("./test_sections_callee.c").find("int32_t f_8(int32_t r3, int32_t r4) {\n") != std::string::npos);
+    ASSERT(caller_out.find(" = f_8(r3, r4);\n") != std::string::npos);
+    ASSERT(caller_out.find("f_d108") == std::string::npos);
+}
+
+void test_decompile_negative() {
+    // addi r3, r3, -0x10
+    std::vector<uchar> code;
+    push_word(code, 0x3863FFF0u);
+    push_word(code, 0x4E800020u);
+    
+    PPC::decompile(ByteSpan(code), "./test_negative.c", 0x100, 1);
+    
+    const std::string out = read_file("./test_negative.c");
+    ASSERT(out.find(" = r3 - 0x10;\n") != std::string::npos);
+    ASSERT(out.find("+ -") == std::string::npos);
+}
+
+void run_decompiler_tests() {
+    TEST(test_decompile_batch)
+    TEST(test_decompile_sections)
+    TEST(test_decompile_negative)
+}
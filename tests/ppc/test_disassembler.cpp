@@ -0,0 +1,70 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <at_tests>
+
+#include "test_disassembler.h"
+#include "mapped_file.h"
+#include "ppc/disassembler.h"
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream input(filename);
+    std::stringstream out;
+    out << input.rdbuf();
+    return out.str();
+}
+
+void test_disassemble_jobs() {
+    // Many small functions, so every job gets several
+    std::vector<uchar> code;
+    for (uint i = 0; i < 500; ++i) {
+        uint words[] = {0x7C0802A6u, 0x38600000u | i, 0x90010014u, 0x4E800020u, 0x00000000u};
+        for (uint j = 0; j < 5 - i % 2; ++j) {
+            code.push_back((uchar)(words[j] >> 24));
+            code.push_back((uchar)(words[j] >> 16));
+            code.push_back((uchar)(words[j] >> 8));
+            code.push_back((uchar)words[j]);
+        }
+    }
+    
+    PPC::disassemble(ByteSpan(code), "./test_serial.ppc", 0x100, true, 1);
+    PPC::disassemble(ByteSpan(code), "./test_parallel.ppc", 0x100, true, 4);
+    
+    std::string serial = read_file("./test_serial.ppc");
+    std::string parallel = read_file("./test_parallel.ppc");
+    ASSERT(serial.find("; function: f_0 at 0x100\n") == 0);
+    ASSERT(serial.find("addi r3, r0, 0x1F3\n") != std::string::npos);
+    ASSERT(serial == parallel);
+}
+
+void test_disassemble_stream() {
+    // Functions longer than one decode chunk, so some straddle the chunk edge
+    std::vector<uchar> code;
+    for (uint i = 0; i < 6; ++i) {
+        for (uint j = 0; j < 1500; ++j) {
+            uint word = 0x38600000u | j;
+            code.push_back((uchar)(word >> 24));
+            code.push_back((uchar)(word >> 16));
+            code.push_back((uchar)(word >> 8));
+            code.push_back((uchar)word);
+        }
+        code.push_back(0x4E);
+        code.push_back(0x80);
+        code.push_back(0x00);
+        code.push_back(0x20);
+    }
+    
+    PPC::disassemble(ByteSpan(code), "./test_stream.ppc", 0x100, true, 1);
+    std::ostringstream streamed;
+    PPC::disassemble_stream(ByteSpan(code), streamed, 0x100, true);
+    
+    std::string expected = read_file("./test_stream.ppc");
+    ASSERT(streamed.str().find("; function: f_1774 at 0x1874\n") != std::string::npos);
+    ASSERT(streamed.str() == expected);
+}
+
+void run_disassembler_tests() {
+    TEST(test_disassemble_jobs)
+    TEST(test_disassemble_stream)
+}
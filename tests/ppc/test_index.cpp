@@ -0,0 +1,53 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_index.h"
+#include "ppc/index.h"
+
+static const std::vector<uchar> code = {
+    0x7C, 0x08, 0x02, 0xA6,     // mflr r0
+    0x7C, 0x64, 0x1A, 0x14,     // add r3, r4, r3
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x00, 0x00, 0x00, 0x00,     // padding
+    0xFC, 0x20, 0x10, 0x90,     // fmr fr1, fr2
+    0x4B, 0xFF, 0xFF, 0xED,     // bl -0x14
+    0x4E, 0x80, 0x00, 0x20,     // blr
+};
+
+void test_index_queries() {
+    PPC::CodeSection section(ByteSpan(code), 0x40);
+    PPC::write_index(section, "./test_index.idx");
+    
+    PPC::SectionIndex index("./test_index.idx");
+    ASSERT(index.is_valid());
+    ASSERT(index.get_base() == 0x40);
+    ASSERT(index.function_count() == 2);
+    ASSERT(index.instruction_count() == 7);
+    
+    const PPC::IndexFunction *first = index.find_function(0x44);
+    ASSERT(first != nullptr && first->start == 0x40 && first->end == 0x4C);
+    ASSERT(index.name(*first) == "f_0");
+    ASSERT(index.find_function(0x4C) == nullptr);
+    ASSERT(index.find_function(0x3C) == nullptr);
+    const PPC::IndexFunction *second = index.find_function(0x58);
+    ASSERT(second != nullptr && index.name(*second) == "f_10");
+    ASSERT(index.find_function(0x5C) == nullptr);
+    
+    const PPC::IndexInstruction *add = index.find_instruction(0x44);
+    ASSERT(add != nullptr && add->word == 0x7C641A14);
+    ASSERT(index.code_name(*add) == "add");
+    ASSERT(index.operands(*add) == PPC::get_variables(PPC::decode(add->word)));
+    ASSERT(index.code_name(*index.find_instruction(0x54)) == "bl");
+    ASSERT(index.find_instruction(0x42) == nullptr);
+    ASSERT(index.find_instruction(0x5C) == nullptr);
+}
+
+void test_index_invalid() {
+    PPC::SectionIndex missing("./test_missing.idx");
+    ASSERT(!missing.is_valid());
+}
+
+void run_index_tests() {
+    TEST(test_index_queries)
+    TEST(test_index_invalid)
+}
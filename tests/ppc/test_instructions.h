@@ -12,6 +12,7 @@ public:
     void test_copy();
     void test_move();
     void test_code_name();
+    void test_mnemonic();
     void test_get_variables();
     void test_used_registers();
     void test_destination_registers();
@@ -0,0 +1,67 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include <at_tests>
+
+#include "test_listing.h"
+#include "ppc/listing.h"
+
+void test_write_symbol() {
+    std::vector<PPC::DecodedInstruction> instructions = {PPC::decode(0x7C0802A6u), PPC::decode(0x4E800020u)};
+    PPC::Symbol symbol = PPC::Symbol(0x1F0, 0x1F4, "f_f0");
+    symbol.instructions = PPC::InstructionSpan(instructions);
+    
+    PPC::ListingWriter writer;
+    writer.set_address_width(0x1000);
+    writer.write_symbol(symbol, 0x100, true);
+    ASSERT(writer.contents() == "; function: f_f0 at 0x1F0\n"
+                                "  0xF0    7C 08 02 A6    mflr r0\n"
+                                "  0xF4    4E 80 00 20    blr \n");
+    
+    writer.clear();
+    writer.write_symbol(symbol, 0x100, false);
+    ASSERT(writer.contents() == "; function: f_f0 at 0x1F0\n"
+                                "mflr r0\n"
+                                "blr \n");
+}
+
+void test_write_blocks() {
+    std::ostringstream output;
+    std::size_t expected = 0;
+    {
+        PPC::ListingWriter writer(output);
+        PPC::DecodedInstruction stw = PPC::decode(0x90010014u);
+        for (uint i = 0; i < 10000; ++i) {
+            writer.write_instruction(stw, i * 4, false);
+            expected += std::string("stw r0, 0x14(r1)\n").length();
+        }
+        // Everything past the first block has already been written out
+        ASSERT(output.str().length() >= PPC::ListingWriter::BLOCK_SIZE);
+    }
+    ASSERT(output.str().length() == expected);
+}
+
+void test_write_branch_names() {
+    std::vector<PPC::DecodedInstruction> code = {
+        PPC::decode(0x4800000Du), PPC::decode(0x48000004u), PPC::decode(0x4E800020u), PPC::decode(0x4E800020u)
+    };
+    std::vector<PPC::Symbol> symbols = {PPC::Symbol(0x100, 0x108, "f_0"), PPC::Symbol(0x10C, 0x10C, "f_c")};
+    symbols[0].instructions = PPC::InstructionSpan(code).subspan(0, 3);
+    symbols[1].instructions = PPC::InstructionSpan(code).subspan(3, 1);
+    PPC::SymbolIndex names(symbols);
+    
+    PPC::ListingWriter writer;
+    writer.set_names(&names);
+    writer.write_symbol(symbols[0], 0x100, false);
+    // Only branches landing on the start of a symbol get a name
+    ASSERT(writer.contents() == "; function: f_0 at 0x100\n"
+                                "bl f_c\n"
+                                "b 0x1\n"
+                                "blr \n");
+}
+
+void run_listing_tests() {
+    TEST(test_write_symbol)
+    TEST(test_write_blocks)
+    TEST(test_write_branch_names)
+}
@@ -0,0 +1,149 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_liveness.h"
+#include "ppc/liveness.h"
+
+static PPC::FunctionRegisters analyze(const std::vector<uint>& words) {
+    std::vector<PPC::DecodedInstruction> instructions;
+    for (uint word : words) {
+        instructions.push_back(PPC::decode(word));
+    }
+    return PPC::analyze_liveness(instructions);
+}
+
+static constexpr uint r(uint number) {
+    return 1u << number;
+}
+
+void test_branch_paths() {
+    // r5 is only written when the branch isn't taken, a straight scan would miss that it's read
+    PPC::FunctionRegisters regs = analyze({
+        0x2C030000,     // cmpwi r3, 0
+        0x41820008,     // beq +0x8
+        0x38A60001,     // addi r5, r6, 1
+        0x7C652A14,     // add r3, r5, r5
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.gpr_in == (r(3) | r(5) | r(6)));
+    ASSERT(regs.gpr_out == r(3));
+    ASSERT(regs.fpr_in == 0 && regs.fpr_out == 0);
+}
+
+void test_loops() {
+    PPC::FunctionRegisters regs = analyze({
+        0x38840001,     // addi r4, r4, 1
+        0x7C042800,     // cmpw r4, r5
+        0x4180FFF8,     // blt -0x8
+        0xFC201090,     // fmr fr1, fr2
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.gpr_in == (r(4) | r(5)));
+    ASSERT(regs.gpr_out == r(4));
+    ASSERT(regs.fpr_in == r(2));
+    ASSERT(regs.fpr_out == r(1));
+}
+
+void test_calls() {
+    // The call leaves r3 set, so reading it after isn't an input
+    PPC::FunctionRegisters regs = analyze({
+        0x7C0802A6,     // mflr r0
+        0x48000101,     // bl +0x100
+        0x38630001,     // addi r3, r3, 1
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.gpr_in == 0);
+    ASSERT(regs.gpr_out == r(3));
+    
+    // And anything written before it is gone by the return
+    regs = analyze({
+        0x38650000,     // addi r3, r5, 0
+        0x48000101,     // bl +0x100
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.gpr_in == r(5));
+    ASSERT(regs.gpr_out == 0);
+    
+    // With a summary of the target, its reads are the caller's and only what it clobbers is lost
+    std::vector<PPC::DecodedInstruction> instructions = {
+        PPC::decode(0x38850000),    // addi r4, r5, 0
+        PPC::decode(0x48000101),    // bl +0x100
+        PPC::decode(0x4E800020),    // blr
+    };
+    const PPC::FunctionRegisters callee {r(4) | r(5), 0, r(3), 0, r(3) | r(6), 0};
+    PPC::LivenessAnalyzer analyzer;
+    regs = analyzer.analyze(instructions, &callee);
+    ASSERT(regs.gpr_in == r(5));
+    ASSERT(regs.gpr_out == (r(3) | r(4)));
+    ASSERT(regs.gpr_clobber == (r(3) | r(4) | r(6)));
+}
+
+void test_exits() {
+    // A conditional return leaves with r3 as it came in, the other path sets it
+    PPC::FunctionRegisters regs = analyze({
+        0x2C030000,     // cmpwi r3, 0
+        0x4D820020,     // beqlr
+        0x38670000,     // addi r3, r7, 0
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.gpr_in == (r(3) | r(7)));
+    ASSERT(regs.gpr_out == r(3));
+    
+    // A branch out of the function is a tail call, and a function can run off the end
+    regs = analyze({
+        0x38630001,     // addi r3, r3, 1
+        0x48000100,     // b +0x100
+    });
+    ASSERT(regs.gpr_in == r(3) && regs.gpr_out == r(3));
+    regs = analyze({
+        0xFC201090,     // fmr fr1, fr2
+    });
+    ASSERT(regs.fpr_in == r(2) && regs.fpr_out == r(1));
+    
+    regs = analyze({});
+    ASSERT(regs.gpr_in == 0 && regs.gpr_out == 0);
+}
+
+void test_prologue() {
+    // The stack pointer and r31 are read to be saved, but only r3 is passed in
+    std::vector<PPC::DecodedInstruction> instructions;
+    for (uint word : std::vector<uint> {
+        0x9421FFF0,     // stwu r1, -0x10(r1)
+        0x7C0802A6,     // mflr r0
+        0x90010014,     // stw r0, 0x14(r1)
+        0x93E1000C,     // stw r31, 0xC(r1)
+        0x7C7F1B78,     // mr r31, r3
+        0x48000101,     // bl +0x100
+        0x7FE3FB78,     // mr r3, r31
+        0x80010014,     // lwz r0, 0x14(r1)
+        0x83E1000C,     // lwz r31, 0xC(r1)
+        0x38210010,     // addi r1, r1, 0x10
+        0x7C0803A6,     // mtlr r0
+        0x4E800020,     // blr
+    }) {
+        instructions.push_back(PPC::decode(word));
+    }
+    PPC::LivenessAnalyzer analyzer;
+    PPC::FunctionRegisters regs = analyzer.analyze(instructions);
+    ASSERT(regs.gpr_in == r(3));
+    ASSERT(regs.gpr_out == r(3));
+    ASSERT(analyzer.entry_gprs() == (r(1) | r(3) | r(31)));
+    
+    // Saved float registers aren't arguments either
+    regs = analyze({
+        0xDBE1FFF8,     // stfd fr31, -0x8(r1)
+        0xFC211028,     // fsub fr1, fr1, fr2
+        0xCBE1FFF8,     // lfd fr31, -0x8(r1)
+        0x4E800020,     // blr
+    });
+    ASSERT(regs.fpr_in == (r(1) | r(2)));
+    ASSERT(regs.gpr_in == 0);
+}
+
+void run_liveness_tests() {
+    TEST(test_branch_paths)
+    TEST(test_loops)
+    TEST(test_calls)
+    TEST(test_exits)
+    TEST(test_prologue)
+}
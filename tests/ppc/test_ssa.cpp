@@ -0,0 +1,192 @@
+#include <vector>
+#include <at_tests>
+
+#include "test_ssa.h"
+#include "ppc/ssa.h"
+
+static std::vector<PPC::DecodedInstruction> decode_all(const std::vector<uint>& words) {
+    std::vector<PPC::DecodedInstruction> out;
+    for (uint word : words) {
+        out.push_back(PPC::decode(word));
+    }
+    return out;
+}
+
+// First value in a block's body with op, or NO_VALUE
+static PPC::ValueId find(const PPC::SSAFunction& ir, uint block, PPC::Op op) {
+    const PPC::SSABlock& range = ir.block(block);
+    for (PPC::ValueId id = range.first_value; id < range.first_value + range.num_values; ++id) {
+        if (ir[id].op == op) {
+            return id;
+        }
+    }
+    return PPC::NO_VALUE;
+}
+
+static bool is_constant(const PPC::SSAFunction& ir, PPC::ValueId id, int value) {
+    return ir[id].op == PPC::Op::CONSTANT && ir[id].constant == value;
+}
+
+void test_ssa_phis() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all({
+        0x2C030000,     // cmpwi r3, 0
+        0x4182000C,     // beq +0xC
+        0x38800001,     // li r4, 1
+        0x48000008,     // b +0x8
+        0x38800002,     // li r4, 2
+        0x7C642214,     // add r3, r4, r4
+        0x4E800020,     // blr
+    });
+    PPC::SSAFunction ir;
+    ir.build(instructions);
+    
+    ASSERT(ir.get_graph().size() == 4);
+    // Only r4 is read after the join, the compare result isn't
+    ASSERT(ir.block(3).num_phis == 1);
+    const PPC::ValueId phi = ir.block(3).first_phi;
+    ASSERT(ir[phi].op == PPC::Op::PHI && ir[phi].variable == 4);
+    PPC::EdgeSpan operands = ir.operands(phi);
+    ASSERT(operands.size() == 2);
+    ASSERT(is_constant(ir, operands[0], 1));
+    ASSERT(is_constant(ir, operands[1], 2));
+    
+    const PPC::ValueId add = find(ir, 3, PPC::Op::ADD);
+    ASSERT(add != PPC::NO_VALUE);
+    ASSERT(ir.operands(add)[0] == phi && ir.operands(add)[1] == phi);
+    const PPC::ValueId ret = find(ir, 3, PPC::Op::RETURN);
+    ASSERT(ret != PPC::NO_VALUE && ir.operands(ret)[0] == add);
+    
+    const PPC::ValueId branch = find(ir, 0, PPC::Op::BRANCH);
+    const PPC::ValueId compare = find(ir, 0, PPC::Op::COMPARE);
+    ASSERT(branch != PPC::NO_VALUE && ir.operands(branch)[0] == compare);
+    const PPC::Value& argument = ir[ir.operands(compare)[0]];
+    ASSERT(argument.op == PPC::Op::ARGUMENT && argument.variable == 3);
+    ASSERT(find(ir, 1, PPC::Op::JUMP) != PPC::NO_VALUE);
+}
+
+void test_ssa_loops() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all({
+        0x38600000,     // li r3, 0
+        0x38630001,     // addi r3, r3, 1
+        0x2C03000A,     // cmpwi r3, 10
+        0x4180FFF8,     // blt -0x8
+        0x4E800020,     // blr
+    });
+    PPC::SSAFunction ir;
+    ir.build(instructions);
+    
+    ASSERT(ir.block(1).num_phis == 1);
+    const PPC::ValueId phi = ir.block(1).first_phi;
+    const PPC::ValueId add = find(ir, 1, PPC::Op::ADD);
+    ASSERT(is_constant(ir, ir.operands(phi)[0], 0));
+    ASSERT(ir.operands(phi)[1] == add);
+    ASSERT(ir.operands(add)[0] == phi);
+    
+    // A loop back to the entry gives its phis one more operand, for the value passed in
+    instructions = decode_all({
+        0x3863FFFF,     // addi r3, r3, -1
+        0x2C030000,     // cmpwi r3, 0
+        0x4082FFF8,     // bne -0x8
+        0x4E800020,     // blr
+    });
+    ir.build(instructions);
+    ASSERT(ir.block(0).num_phis == 1);
+    const PPC::ValueId entry = ir.block(0).first_phi;
+    ASSERT(ir.operands(entry).size() == 2);
+    ASSERT(ir.operands(entry)[0] == find(ir, 0, PPC::Op::ADD));
+    ASSERT(ir[ir.operands(entry)[1]].op == PPC::Op::ARGUMENT);
+}
+
+void test_ssa_calls() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all({
+        0x7C0802A6,     // mflr r0
+        0x48000101,     // bl +0x100
+        0x38630001,     // addi r3, r3, 1
+        0x48000200,     // b +0x200
+    });
+    PPC::SSAFunction ir;
+    ir.build(instructions, 0x80);
+    
+    const PPC::ValueId opaque = find(ir, 0, PPC::Op::OPAQUE);
+    ASSERT(opaque != PPC::NO_VALUE && ir[opaque].variable == 0);
+    const PPC::ValueId call = find(ir, 0, PPC::Op::CALL);
+    ASSERT(call != PPC::NO_VALUE);
+    ASSERT(ir[call].constant == 0x184);
+    ASSERT(ir.operands(call).size() == 16);
+    ASSERT(ir[ir.operands(call)[0]].op == PPC::Op::UNDEFINED);
+    
+    const PPC::ValueId add = find(ir, 0, PPC::Op::ADD);
+    ASSERT(ir.operands(add)[0] == call);
+    
+    // The tail call takes the sum, and its result is returned
+    const PPC::SSABlock& block = ir.block(0);
+    const PPC::ValueId ret = block.first_value + block.num_values - 1;
+    ASSERT(ir[ret].op == PPC::Op::RETURN);
+    const PPC::ValueId tail = ir.operands(ret)[0];
+    ASSERT(ir[tail].op == PPC::Op::CALL && ir[tail].constant == 0x28C);
+    ASSERT(ir.operands(tail)[0] == add);
+}
+
+void test_ssa_memory() {
+    std::vector<PPC::DecodedInstruction> instructions = decode_all({
+        0x80830008,     // lwz r4, 0x8(r3)
+        0x9421FFF0,     // stwu r1, -0x10(r1)
+        0x90810000,     // stw r4, 0x0(r1)
+        0x4E800020,     // blr
+    });
+    PPC::SSAFunction ir;
+    ir.build(instructions);
+    
+    const PPC::ValueId load = find(ir, 0, PPC::Op::LOAD);
+    ASSERT(ir[load].width == 4 && ir[load].type == PPC::ValueType::INT);
+    ASSERT(ir[ir.operands(load)[0]].op == PPC::Op::ARGUMENT);
+    ASSERT(is_constant(ir, ir.operands(load)[1], 8));
+    
+    // The update store moves r1, and the next store goes through the new one
+    PPC::ValueId stores[2];
+    uint count = 0;
+    const PPC::SSABlock& block = ir.block(0);
+    for (PPC::ValueId id = block.first_value; id < block.first_value + block.num_values; ++id) {
+        if (ir[id].op == PPC::Op::STORE && count < 2) {
+            stores[count++] = id;
+        }
+    }
+    ASSERT(count == 2);
+    ASSERT(is_constant(ir, ir.operands(stores[0])[2], -0x10));
+    const PPC::ValueId moved = ir.operands(stores[1])[1];
+    ASSERT(ir[moved].op == PPC::Op::ADD);
+    ASSERT(ir.operands(stores[1])[0] == load);
+}
+
+void test_ssa_reuse() {
+    std::vector<uint> words;
+    for (uint i = 0; i < 2000; ++i) {
+        words.push_back(0x38630001);     // addi r3, r3, 1
+    }
+    words.push_back(0x4E800020);
+    std::vector<PPC::DecodedInstruction> big = decode_all(words);
+    std::vector<PPC::DecodedInstruction> small = decode_all({0x38630001, 0x4E800020});
+    
+    PPC::SSAFunction ir;
+    ir.build(big);
+    const std::size_t big_size = ir.memory_used();
+    ASSERT(ir.size() > 4000);
+    
+    // Building again drops the last function's values all at once
+    ir.build(small);
+    ASSERT(ir.size() < 10);
+    ASSERT(ir.memory_used() < big_size / 10);
+    ir.build(big);
+    ASSERT(ir.memory_used() == big_size);
+    
+    ir.build(PPC::InstructionSpan());
+    ASSERT(ir.size() == 0);
+}
+
+void run_ssa_tests() {
+    TEST(test_ssa_phis)
+    TEST(test_ssa_loops)
+    TEST(test_ssa_calls)
+    TEST(test_ssa_memory)
+    TEST(test_ssa_reuse)
+}
@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+#include <at_tests>
+
+#include "test_symbol_index.h"
+#include "ppc/symbol_index.h"
+
+// Functions of varied lengths with gaps between some of them, given out of order
+static std::vector<PPC::Symbol> make_symbols(std::vector<std::string>& names) {
+    std::vector<PPC::Symbol> out;
+    ulong start = 0x100;
+    for (uint i = 0; i < 100; ++i) {
+        names.push_back("f_" + std::to_string(i));
+    }
+    for (uint i = 0; i < 100; ++i) {
+        ulong length = 4 * (1 + (i * 7) % 5);
+        out.emplace_back(start, start + length - 4, names[i]);
+        start += length + (i % 3 == 0 ? 8 : 0);
+    }
+    std::swap(out[3], out[70]);
+    return out;
+}
+
+static const PPC::Symbol *linear_find(const std::vector<PPC::Symbol>& symbols, ulong address) {
+    for (const auto& symbol : symbols) {
+        if (symbol.start <= address && address <= symbol.end) {
+            return &symbol;
+        }
+    }
+    return nullptr;
+}
+
+void test_index_find() {
+    std::vector<std::string> names;
+    std::vector<PPC::Symbol> symbols = make_symbols(names);
+    PPC::SymbolIndex index(symbols);
+    ASSERT(index.size() == 100);
+    
+    for (ulong address = 0xF0; address < 0x800; address += 2) {
+        const PPC::Symbol *expected = linear_find(symbols, address);
+        const PPC::SymbolIndex::Entry *found = index.find(address);
+        if (expected == nullptr) {
+            ASSERT(found == nullptr);
+        } else {
+            ASSERT(found != nullptr && found->start == expected->start);
+            ASSERT(found != nullptr && &symbols[found->id] == expected);
+        }
+        
+        const PPC::SymbolIndex::Entry *exact = index.at(address);
+        ASSERT((exact != nullptr) == (expected != nullptr && expected->start == address));
+    }
+    ASSERT(index.at(0x100)->name == "f_0");
+    
+    PPC::SymbolIndex empty;
+    ASSERT(empty.find(0x100) == nullptr);
+    ASSERT(empty.at(0) == nullptr);
+}
+
+void test_index_range() {
+    std::vector<std::string> names;
+    std::vector<PPC::Symbol> symbols = make_symbols(names);
+    PPC::SymbolIndex index(symbols);
+    
+    auto range = index.range(0x104, 0x130);
+    std::size_t count = 0;
+    ulong last = 0;
+    for (auto entry = range.first; entry != range.second; ++entry) {
+        ASSERT(entry->start < 0x130 && entry->end >= 0x104);
+        ASSERT(entry->start > last);
+        last = entry->start;
+        count++;
+    }
+    std::size_t expected = 0;
+    for (const auto& symbol : symbols) {
+        expected += symbol.start < 0x130 && symbol.end >= 0x104;
+    }
+    ASSERT(count == expected);
+    
+    range = index.range(0x10000, 0x20000);
+    ASSERT(range.first == range.second);
+}
+
+void run_symbol_index_tests() {
+    TEST(test_index_find)
+    TEST(test_index_range)
+}
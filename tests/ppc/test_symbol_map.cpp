@@ -0,0 +1,121 @@
+#include <string>
+#include <vector>
+#include <at_tests>
+
+#include "test_symbol_map.h"
+#include "ppc/symbol_map.h"
+#include "ppc/code_section.h"
+
+static const std::string map_text =
+    ".init section layout\r\n"
+    "  Starting        Virtual\r\n"
+    "  address  Size   address\r\n"
+    "  -----------------------\r\n"
+    "  00000000 0000f0 80003100  1 .init \tRuntime.PPCEABI.H.a __mem.o \r\n"
+    "  00000000 000024 80003100  4 __start \tos.a __start.o \r\n"
+    "\r\n"
+    ".text section layout\n"
+    "  00000000 000034 80005340  1 .text \tRuntime.PPCEABI.H.a global_destructor_chain.o \n"
+    "  00000034 00003c 80005374  4 __destroy_global_chain \tRuntime.PPCEABI.H.a global_destructor_chain.o \n"
+    "  UNUSED   000020 ........ __unused_thing \tos.a OSAlarm.o \n"
+    "  00000070 000000 800053b0  4 label_only \tos.a OSAlarm.o \n"
+    "800053b0 000008 800053b0 OldStyle\n"
+    ".data section layout\n"
+    "  00000000 000002 80400000  1 small_data \tmain.o \n"
+    "\n"
+    "Memory map:\n"
+    "         .init  80003100  000024a0 00000100\n";
+
+void test_import_map() {
+    Arena arena;
+    std::vector<PPC::Symbol> symbols = PPC::import_map(
+        ByteSpan((const uchar*)map_text.data(), map_text.size()), arena
+    );
+    
+    ASSERT(symbols.size() == 4);
+    if (symbols.size() != 4) {
+        return;
+    }
+    ASSERT(symbols[0].name == "__start");
+    ASSERT(symbols[0].start == 0x80003100 && symbols[0].end == 0x80003120);
+    ASSERT(symbols[1].name == "__destroy_global_chain");
+    ASSERT(symbols[1].start == 0x80005374 && symbols[1].end == 0x800053AC);
+    ASSERT(symbols[2].name == "OldStyle");
+    ASSERT(symbols[3].name == "small_data" && symbols[3].end == symbols[3].start);
+}
+
+void test_symbol_map_file() {
+    std::vector<std::string> names = {"f_40", "main", "f_0"};
+    std::vector<PPC::Symbol> symbols = {
+        PPC::Symbol(0x40, 0x4C, names[0]), PPC::Symbol(0x80, 0x80, names[1]), PPC::Symbol(0x0, 0x3C, names[2])
+    };
+    PPC::write_symbol_map(symbols, "./test_symbols.sym");
+    
+    PPC::SymbolMap map("./test_symbols.sym");
+    ASSERT(map.is_valid());
+    ASSERT(map.size() == 3);
+    // Records come back sorted by start
+    ASSERT(map[0].start == 0x0 && map.name(map[0]) == "f_0");
+    ASSERT(map[1].end == 0x4C && map.name(map[1]) == "f_40");
+    
+    std::vector<PPC::Symbol> loaded = map.symbols();
+    ASSERT(loaded.size() == 3 && loaded[2].name == "main" && loaded[2].start == 0x80);
+    ASSERT(map.find(0x40) == &map[1]);
+    ASSERT(map.find(0x44) == nullptr);
+    
+    ASSERT(!PPC::SymbolMap("./missing_file.sym").is_valid());
+}
+
+void test_load_symbols() {
+    std::vector<std::string> names = {"f_0", "f_c"};
+    std::vector<PPC::Symbol> symbols = {PPC::Symbol(0x100, 0x104, names[0]), PPC::Symbol(0x10C, 0x114, names[1])};
+    PPC::write_symbols(symbols, "./test_symbols.txt");
+    
+    Arena arena;
+    std::vector<PPC::Symbol> loaded = PPC::load_symbols("./test_symbols.txt", arena);
+    ASSERT(loaded.size() == 2);
+    ASSERT(loaded[1].name == "f_c" && loaded[1].start == 0x10C && loaded[1].end == 0x114);
+    
+    // Binary maps load through the same call
+    PPC::write_symbol_map(symbols, "./test_symbols.sym");
+    loaded = PPC::load_symbols("./test_symbols.sym", arena);
+    ASSERT(loaded.size() == 2);
+    ASSERT(loaded[0].name == "f_0" && loaded[0].start == 0x100 && loaded[0].end == 0x104);
+}
+
+// Two functions, loaded at 0x80003100
+static const std::vector<uchar> code = {
+    0x38, 0x60, 0x00, 0x01,     // li r3, 1
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x38, 0x60, 0x00, 0x02,     // li r3, 2
+    0x4E, 0x80, 0x00, 0x20,     // blr
+};
+
+void test_name_symbols() {
+    std::vector<std::string> names = {"second", "elsewhere"};
+    std::vector<PPC::Symbol> symbols = {
+        PPC::Symbol(0x80003108, 0x8000310C, names[0]), PPC::Symbol(0x80004000, 0x80004010, names[1])
+    };
+    PPC::write_symbol_map(symbols, "./test_symbols.sym");
+    
+    PPC::CodeSection section(ByteSpan(code), 0x100);
+    // The index made before naming is made again with the new names
+    ASSERT(section.get_symbol_index().at(0x108)->name == "f_8");
+    {
+        PPC::SymbolMap map("./test_symbols.sym");
+        section.name_symbols(map, 0x80003100);
+    }
+    
+    std::vector<PPC::Symbol>& named = section.get_symbols();
+    ASSERT(named.size() == 2);
+    ASSERT(named[0].name == "f_0");
+    ASSERT(named[1].name == "second" && named[1].start == 0x108);
+    ASSERT(section.get_symbol_index().at(0x108)->name == "second");
+}
+
+void run_symbol_map_tests() {
+    TEST(test_import_map)
+    TEST(test_symbol_map_file)
+    TEST(test_load_symbols)
+    TEST(test_name_symbols)
+}
@@ -1,8 +1,23 @@
 
+#include <fstream>
+#include <vector>
 #include <at_tests>
 
 #include "test_symbols.h"
+#include "mapped_file.h"
 #include "ppc/symbol.h"
+#include "ppc/code_section.h"
+
+// Two functions, the second preceded by alignment padding, then an interrupt handler
+static const std::vector<uchar> code = {
+    0x7C, 0x08, 0x02, 0xA6,     // mflr r0
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x00, 0x00, 0x00, 0x00,     // PADDING
+    0x60, 0x00, 0x00, 0x00,     // nop
+    0x38, 0x60, 0x00, 0x01,     // li r3, 1
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x4C, 0x00, 0x00, 0x64,     // rfi
+};
 
 void test_symbol_creation() {
     throw testing::skip_test();
@@ -12,7 +27,147 @@ void test_start_end() {
     throw testing::skip_test();
 }
 
+void test_generate_symbols() {
+    PPC::CodeSection section(ByteSpan(code), 0x100);
+    std::vector<PPC::Symbol>& symbols = section.get_symbols();
+    
+    ASSERT(symbols.size() == 3);
+    ASSERT(symbols[0].name == "f_0");
+    ASSERT(symbols[0].start == 0x100 && symbols[0].end == 0x104);
+    ASSERT(symbols[1].name == "f_c");
+    ASSERT(symbols[1].start == 0x10C && symbols[1].end == 0x114);
+    ASSERT(symbols[1].instructions.size() == 3);
+    ASSERT(symbols[1].instructions[2].word == 0x4E800020);
+    ASSERT(symbols[2].name == "i_18");
+    
+    // Symbols point into the section's own instructions, nothing is copied
+    ASSERT(symbols[1].instructions.begin() == section.get_instructions().begin() + 3);
+}
+
+void test_generate_symbols_file() {
+    {
+        std::ofstream out("./test_symbols.bin", std::ios::binary);
+        out.write("\0\0\0\0", 4);
+        out.write((const char*)code.data(), code.size());
+    }
+    
+    MappedFile file("./test_symbols.bin");
+    ASSERT(file.is_open());
+    ASSERT(file.size() == code.size() + 4);
+    ASSERT(file.bytes()[4] == 0x7C);
+    ASSERT(file.bytes().subspan(file.size() - 2, 8).size == 2);
+    
+    PPC::CodeSection section(file.bytes().subspan(4), 4);
+    std::vector<PPC::Symbol>& symbols = section.get_symbols();
+    ASSERT(symbols.size() == 3);
+    ASSERT(symbols[1].name == "f_c");
+    ASSERT(symbols[1].start == 0x10 && symbols[1].end == 0x18);
+    
+    ASSERT(!MappedFile("./missing_file.bin").is_open());
+}
+
+// f_0 calls f_10 and f_18. f_10 has no return of its own and tail calls f_28
+static const std::vector<uchar> calls = {
+    0x48, 0x00, 0x00, 0x11,     // bl 0x10
+    0x48, 0x00, 0x00, 0x15,     // bl 0x14
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x00, 0x00, 0x00, 0x00,     // PADDING
+    0x38, 0x60, 0x00, 0x01,     // li r3, 1
+    0x48, 0x00, 0x00, 0x14,     // b 0x14
+    0x7C, 0x08, 0x02, 0xA6,     // mflr r0
+    0x41, 0x82, 0xFF, 0xFC,     // beq -0x4
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x00, 0x00, 0x00, 0x00,     // PADDING
+    0x38, 0x63, 0x00, 0x01,     // addi r3, r3, 1
+    0x4B, 0xFF, 0xFF, 0xFC,     // b -0x4
+    0x4E, 0x80, 0x00, 0x20,     // blr
+};
+
+void test_call_targets() {
+    PPC::CallTargets targets = PPC::find_call_targets(ByteSpan(calls));
+    ASSERT(targets.size() == 13);
+    ASSERT(targets.contains(4));
+    ASSERT(targets.contains(6));
+    ASSERT(targets.contains(10));
+    // Jumps that stay inside one run between returns aren't targets
+    ASSERT(!targets.contains(7));
+    ASSERT(!targets.contains(11));
+    ASSERT(!targets.contains(13));
+    
+    PPC::CodeSection section(ByteSpan(calls), 0x100);
+    PPC::CallTargets decoded = PPC::find_call_targets(section.get_instructions());
+    for (uint i = 0; i < 13; ++i) {
+        ASSERT(decoded.contains(i) == targets.contains(i));
+    }
+    
+    std::vector<PPC::Symbol>& symbols = section.get_symbols();
+    ASSERT(symbols.size() == 4);
+    if (symbols.size() != 4) {
+        return;
+    }
+    ASSERT(symbols[0].name == "f_0" && symbols[0].end == 0x108);
+    ASSERT(symbols[1].name == "f_10");
+    ASSERT(symbols[1].start == 0x110 && symbols[1].end == 0x114);
+    ASSERT(symbols[2].name == "f_18");
+    ASSERT(symbols[2].start == 0x118 && symbols[2].end == 0x120);
+    ASSERT(symbols[3].name == "f_28");
+    ASSERT(symbols[3].instructions.size() == 3);
+}
+
+// f_0 returns early, then carries on where its beq lands. f_18 follows it
+static const std::vector<uchar> returns = {
+    0x2C, 0x03, 0x00, 0x00,     // cmpwi r3, 0
+    0x41, 0x82, 0x00, 0x0C,     // beq 0xC
+    0x38, 0x60, 0x00, 0x01,     // li r3, 1
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x38, 0x60, 0x00, 0x02,     // li r3, 2
+    0x4E, 0x80, 0x00, 0x20,     // blr
+    0x38, 0x60, 0x00, 0x03,     // li r3, 3
+    0x4E, 0x80, 0x00, 0x20,     // blr
+};
+
+void test_multiple_returns() {
+    PPC::CallTargets targets = PPC::find_call_targets(ByteSpan(returns));
+    ASSERT(!targets.ends(3));
+    ASSERT(targets.ends(5));
+    ASSERT(targets.ends(7));
+    
+    PPC::CodeSection section(ByteSpan(returns), 0x100);
+    std::vector<PPC::Symbol>& symbols = section.get_symbols();
+    ASSERT(symbols.size() == 2);
+    if (symbols.size() != 2) {
+        return;
+    }
+    ASSERT(symbols[0].name == "f_0" && symbols[0].end == 0x114);
+    ASSERT(symbols[0].instructions.size() == 6);
+    ASSERT(symbols[1].name == "f_18" && symbols[1].start == 0x118);
+}
+
+void test_generate_inputs_parallel() {
+    std::vector<uchar> many;
+    for (uint i = 0; i < 100; ++i) {
+        many.insert(many.end(), code.begin(), code.end());
+        many.insert(many.end(), calls.begin(), calls.end());
+    }
+    
+    PPC::CodeSection serial {ByteSpan(many)}, parallel {ByteSpan(many)};
+    std::vector<PPC::Symbol>& expected = serial.get_symbols_with_inputs(1);
+    std::vector<PPC::Symbol>& symbols = parallel.get_symbols_with_inputs(4);
+    ASSERT(symbols.size() == expected.size());
+    ASSERT(symbols[1].get_output_regular() == (1u << 3));
+    for (std::size_t i = 0; i < symbols.size() && i < expected.size(); ++i) {
+        ASSERT(symbols[i].get_input_regular() == expected[i].get_input_regular());
+        ASSERT(symbols[i].get_input_float() == expected[i].get_input_float());
+        ASSERT(symbols[i].get_output_regular() == expected[i].get_output_regular());
+    }
+}
+
 void run_symbols_tests() {
     TEST(test_symbol_creation)
     TEST(test_start_end)
+    TEST(test_generate_symbols)
+    TEST(test_generate_symbols_file)
+    TEST(test_call_targets)
+    TEST(test_multiple_returns)
+    TEST(test_generate_inputs_parallel)
 }
@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <string>
+#include <at_tests>
+
+#include "test_arena.h"
+#include "arena.h"
+
+void test_arena_allocate() {
+    Arena arena(256);
+    
+    uchar *byte = arena.allocate_array<uchar>(1);
+    ulong *longs = arena.allocate_array<ulong>(4);
+    ASSERT((std::uintptr_t)longs % alignof(ulong) == 0);
+    ASSERT((uchar*)longs > byte);
+    for (uint i = 0; i < 4; ++i) {
+        longs[i] = i;
+    }
+    
+    // Bigger than a block, gets its own
+    uchar *big = arena.allocate_array<uchar>(1000);
+    big[999] = 1;
+    ASSERT(arena.allocated() == 1 + 4 * sizeof(ulong) + 1000);
+    ASSERT(arena.capacity() >= 256 + 1000);
+    ASSERT(longs[3] == 3);
+    
+    std::string name = "f_80";
+    std::string_view copy = arena.copy(name);
+    name[2] = '9';
+    ASSERT(copy == "f_80");
+    ASSERT(arena.copy("").empty());
+}
+
+void test_arena_reset() {
+    Arena arena(128);
+    for (uint i = 0; i < 10; ++i) {
+        arena.allocate(100);
+    }
+    ASSERT(arena.capacity() >= 1000);
+    
+    arena.reset();
+    ASSERT(arena.allocated() == 0);
+    ASSERT(arena.capacity() == 128);
+    
+    Arena moved = std::move(arena);
+    ASSERT(arena.capacity() == 0);
+    ASSERT(moved.allocate(16) != nullptr);
+    ASSERT(moved.allocated() == 16);
+}
+
+void test_arena_vector() {
+    Arena arena(256);
+    ArenaVector<uint> numbers(arena);
+    ASSERT(numbers.empty());
+    
+    for (uint i = 0; i < 1000; ++i) {
+        numbers.push_back(i * 3);
+    }
+    ASSERT(numbers.size() == 1000);
+    ASSERT(numbers[0] == 0 && numbers[999] == 2997);
+    
+    uint *added = numbers.extend(5);
+    ASSERT(added == numbers.data() + 1000);
+    ASSERT(added[0] == 0 && added[4] == 0);
+    ASSERT(numbers.size() == 1005);
+    
+    uint total = 0;
+    for (uint number : numbers) {
+        total += number;
+    }
+    ASSERT(total == 3 * 999 * 1000 / 2);
+    // Old copies stay with the arena, but never more than the last few doublings
+    ASSERT(arena.allocated() < 4 * 1005 * sizeof(uint));
+}
+
+void run_arena_tests() {
+    TEST(test_arena_allocate)
+    TEST(test_arena_reset)
+    TEST(test_arena_vector)
+}
@@ -0,0 +1,99 @@
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <at_tests>
+
+#include "test_parallel.h"
+#include "parallel.h"
+
+void test_parallel_for() {
+	std::vector<uint> hits(1000, 0);
+	parallel_for(hits.size(), 4, [&](std::size_t i) {
+		hits[i]++;
+	});
+	for (uint hit : hits) {
+		ASSERT(hit == 1);
+	}
+}
+
+void test_scheduler_spawn() {
+	// Each task splits itself until it's a single item, so most work comes from tasks pushed while running
+	TaskScheduler scheduler(4);
+	ASSERT(scheduler.size() == 4);
+	std::vector<uint> hits(4096, 0);
+	std::atomic<uint> tasks {0};
+	std::function<void(std::size_t, std::size_t)> split = [&](std::size_t first, std::size_t last) {
+		tasks++;
+		if (last - first == 1) {
+			hits[first]++;
+			return;
+		}
+		const std::size_t middle = first + (last - first) / 2;
+		scheduler.push([&split, first, middle]() { split(first, middle); });
+		scheduler.push([&split, middle, last]() { split(middle, last); });
+	};
+	scheduler.push([&]() { split(0, 2048); });
+	scheduler.push([&]() { split(2048, 4096); });
+	scheduler.run();
+	
+	for (uint hit : hits) {
+		ASSERT(hit == 1);
+	}
+	ASSERT(tasks == 2 * 4096 - 2);
+	
+	// Runs again once emptied
+	scheduler.push([&]() { hits[0]++; });
+	scheduler.run();
+	ASSERT(hits[0] == 2);
+}
+
+void test_scheduler_error() {
+	TaskScheduler scheduler(3);
+	std::atomic<uint> done {0};
+	for (uint i = 0; i < 100; ++i) {
+		scheduler.push([&done, i]() {
+			if (i == 10) {
+				throw std::runtime_error("task failed");
+			}
+			done++;
+		});
+	}
+	
+	bool thrown = false;
+	try {
+		scheduler.run();
+	} catch (const std::runtime_error& e) {
+		thrown = true;
+	}
+	ASSERT(thrown);
+	ASSERT(done < 100);
+	
+	// The error doesn't stick around for the next run
+	scheduler.push([&done]() { done++; });
+	scheduler.run();
+}
+
+void test_scheduler_idle() {
+	// One long task and three workers with nothing to do, which shouldn't spend the wait spinning
+	TaskScheduler scheduler(4);
+	bool done = false;
+	scheduler.push([&done]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		done = true;
+	});
+	const std::clock_t start = std::clock();
+	scheduler.run();
+	const double seconds = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+	ASSERT(done);
+	ASSERT(seconds < 0.1);
+}
+
+void run_parallel_tests() {
+	TEST(test_parallel_for)
+	TEST(test_scheduler_spawn)
+	TEST(test_scheduler_error)
+	TEST(test_scheduler_idle)
+}
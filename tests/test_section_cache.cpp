@@ -0,0 +1,57 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+#include <at_tests>
+
+#include "test_section_cache.h"
+#include "section_cache.h"
+
+namespace fs = std::experimental::filesystem;
+
+void test_hash_bytes() {
+    // Reference values from the xxHash spec
+    ASSERT(hash_bytes(ByteSpan()) == 0xEF46DB3751D8E999ULL);
+    std::string text = "abc";
+    ASSERT(hash_bytes(ByteSpan((const uchar*)text.data(), text.size())) == 0x44BC2CF5AD770999ULL);
+    
+    std::vector<uchar> data(100);
+    for (uint i = 0; i < data.size(); ++i) {
+        data[i] = (uchar)i;
+    }
+    std::uint64_t whole = hash_bytes(ByteSpan(data));
+    ASSERT(whole == hash_bytes(ByteSpan(data)));
+    ASSERT(whole != hash_bytes(ByteSpan(data), 1));
+    data[99] ^= 1;
+    ASSERT(whole != hash_bytes(ByteSpan(data)));
+}
+
+void test_section_cache() {
+    fs::remove_all("./test_cache");
+    SectionCache cache("./test_cache");
+    
+    std::vector<uchar> code = {0x4E, 0x80, 0x00, 0x20};
+    std::string key = SectionCache::make_key(ByteSpan(code), 0x100, "ppc info");
+    ASSERT(key != SectionCache::make_key(ByteSpan(code), 0x200, "ppc info"));
+    ASSERT(key != SectionCache::make_key(ByteSpan(code), 0x100, "ppc"));
+    
+    ASSERT(!cache.fetch(key, "./test_cached.ppc"));
+    
+    std::ofstream("./test_cached.ppc") << "blr \n";
+    cache.store(key, "./test_cached.ppc");
+    fs::remove("./test_cached.ppc");
+    
+    ASSERT(cache.fetch(key, "./test_cached.ppc"));
+    std::ifstream input("./test_cached.ppc");
+    std::stringstream contents;
+    contents << input.rdbuf();
+    ASSERT(contents.str() == "blr \n");
+    
+    fs::remove_all("./test_cache");
+}
+
+void run_section_cache_tests() {
+    TEST(test_hash_bytes)
+    TEST(test_section_cache)
+}